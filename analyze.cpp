@@ -0,0 +1,441 @@
+// Computes aggregate statistics over telemetry logs recorded by invaders or
+// invaders_runner, e.g.
+//
+//   invaders_analyze --heatmap kills.pgm logs.*.ivtl
+//
+// Logs of other playfields than the default one need the same --width and
+// --height, or --stress, they were recorded with.
+//
+// Logs are memory mapped and processed a window at a time: the blocks of a
+// window are decoded in parallel, every worker reducing into its own partial
+// result, and the pages of a finished window are released again. Datasets much
+// larger than RAM are therefore streamed through the page cache once.
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <print>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "jobs.h"
+#include "telemetry.h"
+
+constexpr size_t ANALYZE_WINDOW_SIZE = 256 << 20;
+// Scores are binned by 10 points, over windows of 10 s at 60 ticks/s
+constexpr size_t SCORE_BIN = 10;
+constexpr size_t SCORE_BINS = 256;
+constexpr size_t TIME_BIN = 600;
+constexpr size_t TIME_BINS = 60;
+
+struct AnalyzeConfig
+{
+    size_t width;
+    size_t height;
+    const char* heatmap_path;
+};
+
+// Each worker only writes its own partial result. The counters are padded so
+// two workers never share a cache line.
+struct alignas(64) AnalyzePartial
+{
+    uint64_t num_ticks;
+    uint64_t num_events;
+    uint64_t num_shots;
+    uint64_t num_lives_lost;
+    uint64_t kills[ALIEN_TYPE_C + 1];
+    // Empty unless a heatmap is written
+    std::vector<uint64_t> heatmap;
+    // score_histogram[time bin][score bin]
+    std::vector<uint64_t> score_histogram;
+    // Decoded columns of the current block
+    std::vector<int64_t> columns[TELEMETRY_MAX_COLUMNS];
+};
+
+void analyze_partial_init(AnalyzePartial* partial, const AnalyzeConfig& config)
+{
+    partial->num_ticks = 0;
+    partial->num_events = 0;
+    partial->num_shots = 0;
+    partial->num_lives_lost = 0;
+    std::fill(std::begin(partial->kills), std::end(partial->kills), 0);
+    partial->heatmap = std::vector<uint64_t>(config.heatmap_path ? config.width * config.height : 0);
+    partial->score_histogram = std::vector<uint64_t>(TIME_BINS * SCORE_BINS);
+
+    for (auto& column : partial->columns)
+    {
+        column = std::vector<int64_t>(TELEMETRY_BLOCK_ROWS);
+    }
+}
+
+void analyze_partial_merge(AnalyzePartial* total, const AnalyzePartial& partial)
+{
+    total->num_ticks += partial.num_ticks;
+    total->num_events += partial.num_events;
+    total->num_shots += partial.num_shots;
+    total->num_lives_lost += partial.num_lives_lost;
+
+    for (size_t i = 0; i < std::size(total->kills); ++i)
+    {
+        total->kills[i] += partial.kills[i];
+    }
+
+    for (size_t i = 0; i < total->heatmap.size(); ++i)
+    {
+        total->heatmap[i] += partial.heatmap[i];
+    }
+
+    for (size_t i = 0; i < total->score_histogram.size(); ++i)
+    {
+        total->score_histogram[i] += partial.score_histogram[i];
+    }
+}
+
+bool analyze_decode(AnalyzePartial* partial, const TelemetryBlockView& view,
+    std::initializer_list<size_t> columns)
+{
+    if (view.num_rows > TELEMETRY_BLOCK_ROWS) return false;
+
+    for (auto column : columns)
+    {
+        if (!telemetry_decode_column(view, column, partial->columns[column].data())) return false;
+    }
+
+    return true;
+}
+
+// Returns false if the block is corrupt
+bool analyze_block(AnalyzePartial* partial, const AnalyzeConfig& config, const TelemetryBlockView& view)
+{
+    if (view.stream == TELEMETRY_EVENTS)
+    {
+        if (!analyze_decode(partial, view, { EVENT_COLUMN_TYPE, EVENT_COLUMN_ALIEN_TYPE,
+            EVENT_COLUMN_X, EVENT_COLUMN_Y }))
+        {
+            return false;
+        }
+
+        const auto& type = partial->columns[EVENT_COLUMN_TYPE];
+        const auto& alien_type = partial->columns[EVENT_COLUMN_ALIEN_TYPE];
+        const auto& x = partial->columns[EVENT_COLUMN_X];
+        const auto& y = partial->columns[EVENT_COLUMN_Y];
+
+        partial->num_events += view.num_rows;
+        for (size_t row = 0; row < view.num_rows; ++row)
+        {
+            switch (type[row])
+            {
+            case EVENT_SHOT_FIRED:
+                ++partial->num_shots;
+                break;
+            case EVENT_ALIEN_KILLED:
+                if (alien_type[row] >= ALIEN_TYPE_A && alien_type[row] <= ALIEN_TYPE_C)
+                {
+                    ++partial->kills[alien_type[row]];
+                }
+                if (!partial->heatmap.empty() &&
+                    size_t(x[row]) < config.width && size_t(y[row]) < config.height)
+                {
+                    ++partial->heatmap[y[row] * config.width + x[row]];
+                }
+                break;
+            case EVENT_LIFE_LOST:
+                ++partial->num_lives_lost;
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    else if (view.stream == TELEMETRY_TICKS)
+    {
+        if (!analyze_decode(partial, view, { TICK_COLUMN_TICK, TICK_COLUMN_SCORE })) return false;
+
+        const auto& tick = partial->columns[TICK_COLUMN_TICK];
+        const auto& score = partial->columns[TICK_COLUMN_SCORE];
+
+        partial->num_ticks += view.num_rows;
+        for (size_t row = 0; row < view.num_rows; ++row)
+        {
+            size_t time_bin = std::min<size_t>(tick[row] / TIME_BIN, TIME_BINS - 1);
+            size_t score_bin = std::min<size_t>(score[row] / SCORE_BIN, SCORE_BINS - 1);
+            ++partial->score_histogram[time_bin * SCORE_BINS + score_bin];
+        }
+    }
+
+    return true;
+}
+
+// Processes one log, returns false if it cannot be read or is corrupt
+bool analyze_file(const char* path, const AnalyzeConfig& config, JobSystem* jobs,
+    std::vector<AnalyzePartial>* partials)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        std::println("Error opening {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        std::println("Error reading {}", path);
+        close(fd);
+        return false;
+    }
+
+    size_t size = st.st_size;
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::println("Error mapping {}: {}", path, std::strerror(errno));
+        return false;
+    }
+
+    auto data = static_cast<const uint8_t*>(mapping);
+    auto end = data + size;
+    madvise(mapping, size, MADV_SEQUENTIAL);
+
+    auto block = telemetry_first_block(data, size);
+    if (!block)
+    {
+        std::println("{} is not a telemetry log", path);
+        munmap(mapping, size);
+        return false;
+    }
+
+    // Only the block headers are touched to find a window's blocks, the
+    // columns are decoded by the workers
+    std::vector<TelemetryBlockView> views;
+    std::vector<uint8_t> corrupt(jobs_num_workers(*jobs));
+    bool ok = true;
+    bool truncated = false;
+
+    while (block < end && ok && !truncated)
+    {
+        auto window_begin = block;
+        views.clear();
+
+        TelemetryBlockView view;
+        while (block < end && block - window_begin < ptrdiff_t(ANALYZE_WINDOW_SIZE))
+        {
+            auto next = telemetry_read_block(block, end, &view);
+            if (!next)
+            {
+                // Only the last block may be cut short, anything else is corrupt
+                if (telemetry_is_partial_block(block, end)) truncated = true;
+                else ok = false;
+                break;
+            }
+
+            views.push_back(view);
+            block = next;
+        }
+
+        // Read ahead the next window while this one is processed
+        if (block < end && ok && !truncated)
+        {
+            size_t page = sysconf(_SC_PAGESIZE);
+            auto ahead = reinterpret_cast<uintptr_t>(block) & ~(page - 1);
+            size_t length = std::min<size_t>(ANALYZE_WINDOW_SIZE, end - reinterpret_cast<const uint8_t*>(ahead));
+            madvise(reinterpret_cast<void*>(ahead), length, MADV_WILLNEED);
+        }
+
+        jobs_parallel_for(jobs, views.size(), 4, [&](size_t begin, size_t end, size_t worker)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (!analyze_block(&(*partials)[worker], config, views[i])) corrupt[worker] = 1;
+            }
+        });
+
+        for (auto flag : corrupt)
+        {
+            if (flag) ok = false;
+        }
+
+        // Drop the pages of the finished window, leaving room for the next
+        size_t page = sysconf(_SC_PAGESIZE);
+        auto release_end = reinterpret_cast<uintptr_t>(block) & ~(page - 1);
+        auto release_begin = reinterpret_cast<uintptr_t>(window_begin) & ~(page - 1);
+        if (release_end > release_begin)
+        {
+            madvise(reinterpret_cast<void*>(release_begin), release_end - release_begin, MADV_DONTNEED);
+        }
+    }
+
+    // A log which is still being written or was cut short ends with a partial block
+    if (ok && truncated)
+    {
+        std::println("Warning: {} has {} trailing bytes which are not a complete block",
+            path, end - block);
+    }
+
+    if (!ok) std::println("Error: {} is corrupt", path);
+
+    munmap(mapping, size);
+    return ok;
+}
+
+bool write_heatmap(const char* path, const AnalyzePartial& total, const AnalyzeConfig& config)
+{
+    FILE* file = std::fopen(path, "wb");
+    if (!file) return false;
+
+    uint64_t max_count = 1;
+    for (auto count : total.heatmap)
+    {
+        max_count = std::max(max_count, count);
+    }
+
+    // Binary PGM, flipped so the top of the playfield is the first row
+    std::fprintf(file, "P5\n%zu %zu\n255\n", config.width, config.height);
+    std::vector<uint8_t> row(config.width);
+    for (size_t y = config.height; y-- > 0;)
+    {
+        for (size_t x = 0; x < config.width; ++x)
+        {
+            row[x] = total.heatmap[y * config.width + x] * 255 / max_count;
+        }
+        std::fwrite(row.data(), 1, row.size(), file);
+    }
+
+    return std::fclose(file) == 0;
+}
+
+size_t histogram_percentile(const uint64_t* bins, uint64_t count, double percentile)
+{
+    uint64_t target = uint64_t(percentile * count);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < SCORE_BINS; ++i)
+    {
+        sum += bins[i];
+        if (sum > target) return i * SCORE_BIN;
+    }
+    return (SCORE_BINS - 1) * SCORE_BIN;
+}
+
+void print_report(const AnalyzePartial& total)
+{
+    std::println("ticks:        {}", total.num_ticks);
+    std::println("events:       {}", total.num_events);
+    std::println("shots:        {}", total.num_shots);
+    std::println("lives lost:   {}", total.num_lives_lost);
+
+    uint64_t total_kills = total.kills[ALIEN_TYPE_A] + total.kills[ALIEN_TYPE_B] + total.kills[ALIEN_TYPE_C];
+    std::println("kills:        {} ({:.1f}% of shots)", total_kills,
+        total.num_shots ? 100.0 * total_kills / total.num_shots : 0.0);
+
+    const char* names[] = { "", "A", "B", "C" };
+    for (size_t type = ALIEN_TYPE_A; type <= ALIEN_TYPE_C; ++type)
+    {
+        std::println("  type {}:     {} ({:.1f}% of kills, {:.2f} per 1000 ticks)", names[type],
+            total.kills[type], total_kills ? 100.0 * total.kills[type] / total_kills : 0.0,
+            total.num_ticks ? 1000.0 * total.kills[type] / total.num_ticks : 0.0);
+    }
+
+    std::println("score over time (p10 / p50 / p90):");
+    for (size_t t = 0; t < TIME_BINS; ++t)
+    {
+        const uint64_t* bins = total.score_histogram.data() + t * SCORE_BINS;
+        uint64_t count = 0;
+        for (size_t i = 0; i < SCORE_BINS; ++i) count += bins[i];
+        if (count == 0) continue;
+
+        std::println("  {:4}s {}{:6} {:6} {:6}  ({} ticks)", t * TIME_BIN / 60,
+            t == TIME_BINS - 1 ? "+" : " ",
+            histogram_percentile(bins, count, 0.1), histogram_percentile(bins, count, 0.5),
+            histogram_percentile(bins, count, 0.9), count);
+    }
+}
+
+void print_usage()
+{
+    std::println("Usage: invaders_analyze [options] LOG...");
+    std::println("  --threads T     number of threads (default: number of CPUs)");
+    std::println("  --heatmap FILE  write the kill heatmap as a PGM image");
+    std::println("The heatmap covers the playfield the logs were recorded with:");
+    game_config_print_usage();
+}
+
+int main(int argc, char** argv)
+{
+    AnalyzeConfig config;
+    config.heatmap_path = nullptr;
+    GameConfig game_config = game_default_config();
+
+    size_t num_threads = 0;
+    std::vector<const char*> paths;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (!std::strcmp(argv[i], "--threads") && has_value)
+            num_threads = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--heatmap") && has_value)
+            config.heatmap_path = argv[++i];
+        else if (game_config_parse_option(&game_config, argc, argv, &i))
+            continue;
+        else if (argv[i][0] == '-')
+        {
+            print_usage();
+            return -1;
+        }
+        else
+            paths.push_back(argv[i]);
+    }
+
+    if (paths.empty())
+    {
+        print_usage();
+        return -1;
+    }
+
+    game_config_finish(&game_config);
+    config.width = game_config.width;
+    config.height = game_config.height;
+
+    JobSystem jobs;
+    jobs_init(&jobs, num_threads);
+
+    std::vector<AnalyzePartial> partials(jobs_num_workers(jobs));
+    for (auto& partial : partials)
+    {
+        analyze_partial_init(&partial, config);
+    }
+
+    bool ok = true;
+    for (auto path : paths)
+    {
+        ok = analyze_file(path, config, &jobs, &partials) && ok;
+    }
+
+    jobs_shutdown(&jobs);
+
+    AnalyzePartial total;
+    analyze_partial_init(&total, config);
+    for (const auto& partial : partials)
+    {
+        analyze_partial_merge(&total, partial);
+    }
+
+    print_report(total);
+
+    if (config.heatmap_path && !write_heatmap(config.heatmap_path, total, config))
+    {
+        std::println("Error writing {}", config.heatmap_path);
+        ok = false;
+    }
+
+    return ok ? 0 : -1;
+}
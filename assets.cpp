@@ -0,0 +1,339 @@
+#include "assets.h"
+
+void assets_init(GameAssets* assets)
+{
+    assets->alien_sprites[0].width = 8;
+    assets->alien_sprites[0].height = 8;
+    assets->alien_sprites[0].data = std::vector<uint8_t>
+    {
+        0,0,0,1,1,0,0,0, // ...@@...
+        0,0,1,1,1,1,0,0, // ..@@@@..
+        0,1,1,1,1,1,1,0, // .@@@@@@.
+        1,1,0,1,1,0,1,1, // @@.@@.@@
+        1,1,1,1,1,1,1,1, // @@@@@@@@
+        0,1,0,1,1,0,1,0, // .@.@@.@.
+        1,0,0,0,0,0,0,1, // @......@
+        0,1,0,0,0,0,1,0  // .@....@.
+    };
+
+    assets->alien_sprites[1].width = 8;
+    assets->alien_sprites[1].height = 8;
+    assets->alien_sprites[1].data = std::vector<uint8_t>
+    {
+        0,0,0,1,1,0,0,0, // ...@@...
+        0,0,1,1,1,1,0,0, // ..@@@@..
+        0,1,1,1,1,1,1,0, // .@@@@@@.
+        1,1,0,1,1,0,1,1, // @@.@@.@@
+        1,1,1,1,1,1,1,1, // @@@@@@@@
+        0,0,1,0,0,1,0,0, // ..@..@..
+        0,1,0,1,1,0,1,0, // .@.@@.@.
+        1,0,1,0,0,1,0,1  // @.@..@.@
+    };
+
+    assets->alien_sprites[2].width = 11;
+    assets->alien_sprites[2].height = 8;
+    assets->alien_sprites[2].data = std::vector<uint8_t>
+    {
+        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+        0,0,0,1,0,0,0,1,0,0,0, // ...@...@...
+        0,0,1,1,1,1,1,1,1,0,0, // ..@@@@@@@..
+        0,1,1,0,1,1,1,0,1,1,0, // .@@.@@@.@@.
+        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+        1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
+        1,0,1,0,0,0,0,0,1,0,1, // @.@.....@.@
+        0,0,0,1,1,0,1,1,0,0,0  // ...@@.@@...
+    };
+
+    assets->alien_sprites[3].width = 11;
+    assets->alien_sprites[3].height = 8;
+    assets->alien_sprites[3].data = std::vector<uint8_t>
+    {
+        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+        1,0,0,1,0,0,0,1,0,0,1, // @..@...@..@
+        1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
+        1,1,1,0,1,1,1,0,1,1,1, // @@@.@@@.@@@
+        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+        0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
+        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
+        0,1,0,0,0,0,0,0,0,1,0  // .@.......@.
+    };
+
+    assets->alien_sprites[4].width = 12;
+    assets->alien_sprites[4].height = 8;
+    assets->alien_sprites[4].data = std::vector<uint8_t>
+    {
+        0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
+        0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
+        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+        1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
+        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+        0,0,0,1,1,0,0,1,1,0,0,0, // ...@@..@@...
+        0,0,1,1,0,1,1,0,1,1,0,0, // ..@@.@@.@@..
+        1,1,0,0,0,0,0,0,0,0,1,1  // @@........@@
+    };
+
+
+    assets->alien_sprites[5].width = 12;
+    assets->alien_sprites[5].height = 8;
+    assets->alien_sprites[5].data = std::vector<uint8_t>
+    {
+        0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
+        0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
+        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+        1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
+        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
+        0,0,1,1,1,0,0,1,1,1,0,0, // ..@@@..@@@..
+        0,1,1,0,0,1,1,0,0,1,1,0, // .@@..@@..@@.
+        0,0,1,1,0,0,0,0,1,1,0,0  // ..@@....@@..
+    };
+
+    assets->alien_death_sprite.width = 13;
+    assets->alien_death_sprite.height = 7;
+    assets->alien_death_sprite.data = std::vector<uint8_t>
+    {
+        0,1,0,0,1,0,0,0,1,0,0,1,0, // .@..@...@..@.
+        0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
+        0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
+        1,1,0,0,0,0,0,0,0,0,0,1,1, // @@.........@@
+        0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
+        0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
+        0,1,0,0,1,0,0,0,1,0,0,1,0  // .@..@...@..@.
+    };
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        auto& animation = assets->alien_animation[i];
+        animation.first_frame = 2 * i;
+        animation.num_frames = 2;
+        animation.frame_duration = 10;
+    }
+
+    assets->player_sprite.width = 11;
+    assets->player_sprite.height = 7;
+    assets->player_sprite.data = std::vector<uint8_t>
+    {
+        0,0,0,0,0,1,0,0,0,0,0, // .....@.....
+        0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
+        0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
+        0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
+        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
+    };
+
+    assets->ufo_sprite.width = 16;
+    assets->ufo_sprite.height = 7;
+    assets->ufo_sprite.data = std::vector<uint8_t>
+    {
+        0,0,0,0,0,1,1,1,1,1,1,0,0,0,0,0, // .....@@@@@@.....
+        0,0,0,1,1,1,1,1,1,1,1,1,1,0,0,0, // ...@@@@@@@@@@...
+        0,0,1,1,1,1,1,1,1,1,1,1,1,1,0,0, // ..@@@@@@@@@@@@..
+        0,1,1,0,1,1,0,1,1,0,1,1,0,1,1,0, // .@@.@@.@@.@@.@@.
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@
+        0,0,1,1,1,0,0,1,1,0,0,1,1,1,0,0, // ..@@@..@@..@@@..
+        0,0,0,1,0,0,0,0,0,0,0,0,1,0,0,0  // ...@........@...
+    };
+
+    assets->text_spritesheet.width = 5;
+    assets->text_spritesheet.height = 7;
+    assets->text_spritesheet.data = std::vector<uint8_t> // 65 chars x 35 pixels each
+    {
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+        0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
+        0,1,0,1,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+        0,1,0,1,0,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,0,1,0,1,0,
+        0,0,1,0,0,0,1,1,1,0,1,0,1,0,0,0,1,1,1,0,0,0,1,0,1,0,1,1,1,0,0,0,1,0,0,
+        1,1,0,1,0,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,0,1,0,1,1,
+        0,1,1,0,0,1,0,0,1,0,1,0,0,1,0,0,1,1,0,0,1,0,0,1,0,1,0,0,0,1,0,1,1,1,1,
+        0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
+        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
+        0,0,1,0,0,1,0,1,0,1,0,1,1,1,0,0,0,1,0,0,0,1,1,1,0,1,0,1,0,1,0,0,1,0,0,
+        0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,
+        0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
+
+        0,1,1,1,0,1,0,0,0,1,1,0,0,1,1,1,0,1,0,1,1,1,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        0,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
+        0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
+        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        0,0,0,1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,0,1,1,1,1,1,0,0,0,1,0,0,0,0,1,0,
+        1,1,1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+
+        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,
+        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
+        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
+        0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,
+        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
+        0,1,1,1,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,1,0,1,1,1,0,1,1,1,0,1,0,0,1,0,0,0,1,0,1,1,1,0,
+
+        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,
+        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,1,0,
+        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
+        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
+        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,1,1,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
+        0,1,1,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
+        0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,1,0,0,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
+        1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
+        1,0,0,0,1,1,1,0,1,1,1,0,1,0,1,1,0,1,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
+        1,0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,0,1,0,1,1,0,0,1,1,1,0,0,0,1,1,0,0,0,1,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,0,1,1,0,1,1,1,1,
+        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
+        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,1,1,1,0,
+        1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
+        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
+        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,
+        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,1,0,1,1,1,0,1,1,1,0,0,0,1,
+        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,
+        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
+        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
+
+        0,0,0,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,1,
+        0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,
+        1,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,0,
+        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,
+        0,0,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+    };
+
+    assets->number_spritesheet.width = 5;
+    assets->number_spritesheet.height = 7;
+    assets->number_spritesheet.data = std::vector(
+        assets->text_spritesheet.data.begin() + 16 * 35, assets->text_spritesheet.data.end());
+
+    assets->bullet_sprite.width = 1;
+    assets->bullet_sprite.height = 3;
+    assets->bullet_sprite.data = std::vector<uint8_t>
+    {
+        1, // @
+        1, // @
+        1  // @
+    };
+
+    assets->alien_bullet_sprites[0].width = 3;
+    assets->alien_bullet_sprites[0].height = 7;
+    assets->alien_bullet_sprites[0].data = std::vector<uint8_t>
+    {
+        0,1,0, // .@.
+        0,1,1, // .@@
+        0,1,0, // .@.
+        1,1,0, // @@.
+        0,1,0, // .@.
+        0,1,1, // .@@
+        0,1,0  // .@.
+    };
+
+    assets->alien_bullet_sprites[1].width = 3;
+    assets->alien_bullet_sprites[1].height = 7;
+    assets->alien_bullet_sprites[1].data = std::vector<uint8_t>
+    {
+        0,1,0, // .@.
+        0,1,0, // .@.
+        0,1,0, // .@.
+        0,1,0, // .@.
+        0,1,0, // .@.
+        0,1,0, // .@.
+        1,1,1  // @@@
+    };
+
+    assets->alien_bullet_sprites[2].width = 3;
+    assets->alien_bullet_sprites[2].height = 7;
+    assets->alien_bullet_sprites[2].data = std::vector<uint8_t>
+    {
+        0,1,0, // .@.
+        1,0,0, // @..
+        0,1,0, // .@.
+        0,0,1, // ..@
+        0,1,0, // .@.
+        1,0,0, // @..
+        0,1,0  // .@.
+    };
+
+    assets->shield_sprite.width = 22;
+    assets->shield_sprite.height = 16;
+    assets->shield_sprite.data = std::vector<uint8_t>
+    {
+        0,0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0,0, // ....@@@@@@@@@@@@@@....
+        0,0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0,0, // ...@@@@@@@@@@@@@@@@...
+        0,0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0,0, // ..@@@@@@@@@@@@@@@@@@..
+        0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@@@@@@@@@@@.
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@@@@@@@@@@@
+        1,1,1,1,1,1,1,0,0,0,0,0,0,0,0,1,1,1,1,1,1,1, // @@@@@@@........@@@@@@@
+        1,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,1, // @@@@@@..........@@@@@@
+        1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1, // @@@@@............@@@@@
+        1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1  // @@@@@............@@@@@
+    };
+
+    assets->shield_explosion_sprite.width = 8;
+    assets->shield_explosion_sprite.height = 8;
+    assets->shield_explosion_sprite.data = std::vector<uint8_t>
+    {
+        1,0,0,0,1,0,0,1, // @...@..@
+        0,0,1,0,0,0,1,0, // ..@...@.
+        0,1,1,1,1,1,1,0, // .@@@@@@.
+        1,1,1,1,1,1,1,1, // @@@@@@@@
+        1,1,1,1,1,1,1,1, // @@@@@@@@
+        0,1,1,1,1,1,1,0, // .@@@@@@.
+        0,0,1,0,0,1,0,0, // ..@..@..
+        1,0,0,1,0,0,0,1  // @..@...@
+    };
+
+    assets->shield_packed = sprite_pack(assets->shield_sprite);
+
+    // An explosion whose left edge is at shield column c uses shift
+    // s = c + width, so s covers all placements overlapping the shield
+    auto explosion = sprite_pack(assets->shield_explosion_sprite);
+    size_t num_shifts = assets->shield_sprite.width + explosion.width;
+    assets->shield_erosion_masks = std::vector<uint64_t>(num_shifts * explosion.height);
+    for (size_t s = 0; s < num_shifts; ++s)
+    {
+        for (size_t row = 0; row < explosion.height; ++row)
+        {
+            assets->shield_erosion_masks[s * explosion.height + row] = uint64_t(explosion.rows[row]) << s;
+        }
+    }
+
+    // Dives start and end at the alien's place in the formation, y points up.
+    // The first and last points are repeated so the path stops there.
+    const float dive_hook[] = {
+        0, 0,  0, 0,  12, 10,  30, 0,  40, -40,  20, -90,  -10, -120,
+        -40, -90,  -30, -40,  -10, -10,  0, 0,  0, 0
+    };
+    const float dive_loop[] = {
+        0, 0,  0, 0,  -10, 12,  -30, 4,  -30, -50,  0, -110,  40, -150,
+        60, -110,  30, -80,  -10, -100,  -40, -60,  -20, -15,  0, 0,  0, 0
+    };
+    constexpr size_t hook_points = sizeof(dive_hook) / sizeof(float) / 2;
+
+    float mirrored[2 * hook_points];
+    for (size_t i = 0; i < hook_points; ++i)
+    {
+        mirrored[2 * i] = -dive_hook[2 * i];
+        mirrored[2 * i + 1] = dive_hook[2 * i + 1];
+    }
+
+    assets->dive_paths = SplineSet{};
+    spline_add_catmull_rom(&assets->dive_paths, dive_hook, hook_points);
+    spline_add_catmull_rom(&assets->dive_paths, mirrored, hook_points);
+    spline_add_catmull_rom(&assets->dive_paths, dive_loop, sizeof(dive_loop) / sizeof(float) / 2);
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "buffer.h"
+#include "spline.h"
+
+// A looping animation over consecutive sprites of a sprite array. The frame on
+// screen only depends on the tick, so one animation serves any number of
+// entities without any state of their own.
+struct SpriteAnimation
+{
+    size_t first_frame;
+    size_t num_frames;
+    // In ticks
+    size_t frame_duration;
+};
+
+// Index into the sprite array of the frame shown at the given tick
+inline size_t sprite_animation_frame(const SpriteAnimation& animation, uint64_t tick)
+{
+    return animation.first_frame + (tick / animation.frame_duration) % animation.num_frames;
+}
+
+// All the sprites of the game. These are read-only once initialized, so a single
+// instance can be shared by any number of games.
+struct GameAssets
+{
+    Sprite alien_sprites[6];
+    Sprite alien_death_sprite;
+    // Over alien_sprites
+    SpriteAnimation alien_animation[3];
+    Sprite player_sprite;
+    Sprite ufo_sprite;
+    Sprite text_spritesheet;
+    Sprite number_spritesheet;
+    Sprite bullet_sprite;
+    // The rolling, plunger and squiggly shots of the aliens
+    Sprite alien_bullet_sprites[3];
+    Sprite shield_sprite;
+    Sprite shield_explosion_sprite;
+
+    // Derived from the sprites above by assets_init()
+    PackedSprite shield_packed;
+    // The explosion mask placed at every column it can overlap the shield at:
+    // entry [s * height + row] has the mask's left edge at bit s, see game.cpp
+    std::vector<uint64_t> shield_erosion_masks;
+
+    // Paths of the diving aliens, relative to their place in the formation
+    SplineSet dive_paths;
+};
+
+void assets_init(GameAssets* assets);
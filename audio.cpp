@@ -0,0 +1,527 @@
+#include "audio.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <numbers>
+#include <print>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(INVADERS_PULSEAUDIO)
+#include <pulse/error.h>
+#include <pulse/simple.h>
+#endif
+
+// Set in ticks_done by audio_shutdown(), so the waiting thread wakes up
+constexpr uint64_t AUDIO_QUIT = uint64_t(1) << 63;
+// Samples the device buffers ahead, three ticks
+constexpr size_t AUDIO_DEVICE_LATENCY = 3 * AUDIO_SAMPLES_PER_TICK;
+
+// The sounds are synthesized once at startup, nothing is loaded from disk
+
+static void synth_square(std::vector<float>* sound, size_t length, float frequency, float decay, float gain)
+{
+    sound->resize(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        float t = float(i) / AUDIO_SAMPLE_RATE;
+        float phase = t * frequency - std::floor(t * frequency);
+        (*sound)[i] = (phase < 0.5f ? gain : -gain) * std::exp(-decay * t);
+    }
+}
+
+// A square wave whose frequency slides linearly from start to end
+static void synth_sweep(std::vector<float>* sound, size_t length, float start, float end, float gain)
+{
+    sound->resize(length);
+    float phase = 0.0f;
+    for (size_t i = 0; i < length; ++i)
+    {
+        float f = start + (end - start) * float(i) / length;
+        phase += f / AUDIO_SAMPLE_RATE;
+        phase -= std::floor(phase);
+        float envelope = 1.0f - float(i) / length;
+        (*sound)[i] = (phase < 0.5f ? gain : -gain) * envelope;
+    }
+}
+
+// Low-passed white noise, a smaller smoothing gives a duller explosion
+static void synth_noise(std::vector<float>* sound, size_t length, float smoothing, float decay, float gain)
+{
+    sound->resize(length);
+    uint32_t state = 0x9e3779b9u;
+    float value = 0.0f;
+    for (size_t i = 0; i < length; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        float noise = float(state) / float(UINT32_MAX) * 2.0f - 1.0f;
+        value += smoothing * (noise - value);
+
+        float t = float(i) / AUDIO_SAMPLE_RATE;
+        (*sound)[i] = value * gain * std::exp(-decay * t);
+    }
+}
+
+// The UFO's warble: a sine whose frequency wobbles around the carrier. The loop
+// holds exactly one wobble and a whole number of carrier periods, so it repeats
+// without a click.
+static void synth_warble(std::vector<float>* sound, size_t length, float carrier, float depth, float gain)
+{
+    constexpr float TWO_PI = 2.0f * std::numbers::pi_v<float>;
+    float wobble = float(AUDIO_SAMPLE_RATE) / length;
+
+    sound->resize(length);
+    for (size_t i = 0; i < length; ++i)
+    {
+        float t = float(i) / AUDIO_SAMPLE_RATE;
+        float phase = carrier * t + depth / (TWO_PI * wobble) * (1.0f - std::cos(TWO_PI * wobble * t));
+        (*sound)[i] = gain * std::sin(TWO_PI * phase);
+    }
+}
+
+static void audio_synthesize(Audio* audio)
+{
+    constexpr float MARCH_FREQUENCIES[4] = { 98.0f, 87.3f, 77.8f, 73.4f };
+    for (size_t i = 0; i < 4; ++i)
+    {
+        synth_square(&audio->sounds[SOUND_MARCH_0 + i], AUDIO_SAMPLE_RATE / 10, MARCH_FREQUENCIES[i], 20.0f, 0.3f);
+    }
+
+    synth_sweep(&audio->sounds[SOUND_SHOT], AUDIO_SAMPLE_RATE * 3 / 20, 1200.0f, 300.0f, 0.12f);
+    synth_noise(&audio->sounds[SOUND_ALIEN_KILLED], AUDIO_SAMPLE_RATE / 4, 0.5f, 12.0f, 0.4f);
+    synth_noise(&audio->sounds[SOUND_PLAYER_KILLED], AUDIO_SAMPLE_RATE, 0.1f, 3.0f, 0.8f);
+    synth_warble(&audio->sounds[SOUND_UFO], AUDIO_SAMPLE_RATE / 5, 400.0f, 100.0f, 0.12f);
+    synth_sweep(&audio->sounds[SOUND_UFO_KILLED], AUDIO_SAMPLE_RATE / 2, 300.0f, 1500.0f, 0.15f);
+    synth_square(&audio->sounds[SOUND_SHOTS_COLLIDED], AUDIO_SAMPLE_RATE / 20, 2000.0f, 60.0f, 0.1f);
+}
+
+// out += in * gain
+static void mix_add(float* out, const float* in, size_t length, float gain)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 g = _mm_set1_ps(gain);
+    for (; i + 4 <= length; i += 4)
+    {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g));
+        _mm_storeu_ps(out + i, sum);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        out[i] += in[i] * gain;
+    }
+}
+
+static void mix_to_pcm(int16_t* out, const float* in, size_t length)
+{
+    size_t i = 0;
+#if defined(__SSE2__)
+    __m128 low = _mm_set1_ps(-1.0f);
+    __m128 high = _mm_set1_ps(1.0f);
+    __m128 scale = _mm_set1_ps(32767.0f);
+    for (; i + 8 <= length; i += 8)
+    {
+        __m128 a = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), low), high), scale);
+        __m128 b = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), low), high), scale);
+        __m128i pcm = _mm_packs_epi32(_mm_cvtps_epi32(a), _mm_cvtps_epi32(b));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), pcm);
+    }
+#endif
+    for (; i < length; ++i)
+    {
+        out[i] = int16_t(std::lround(std::clamp(in[i], -1.0f, 1.0f) * 32767.0f));
+    }
+}
+
+static void wav_write_u32(FILE* file, uint32_t value)
+{
+    uint8_t bytes[4] = { uint8_t(value), uint8_t(value >> 8), uint8_t(value >> 16), uint8_t(value >> 24) };
+    fwrite(bytes, 1, 4, file);
+}
+
+static void wav_write_u16(FILE* file, uint16_t value)
+{
+    uint8_t bytes[2] = { uint8_t(value), uint8_t(value >> 8) };
+    fwrite(bytes, 1, 2, file);
+}
+
+// The sizes are only known at the end, audio_shutdown() writes the header again
+static void wav_write_header(FILE* file, uint32_t num_samples)
+{
+    uint32_t data_size = num_samples * 2;
+
+    fwrite("RIFF", 1, 4, file);
+    wav_write_u32(file, 36 + data_size);
+    fwrite("WAVEfmt ", 1, 8, file);
+    wav_write_u32(file, 16);
+    wav_write_u16(file, 1);
+    wav_write_u16(file, 1);
+    wav_write_u32(file, AUDIO_SAMPLE_RATE);
+    wav_write_u32(file, AUDIO_SAMPLE_RATE * 2);
+    wav_write_u16(file, 2);
+    wav_write_u16(file, 16);
+    fwrite("data", 1, 4, file);
+    wav_write_u32(file, data_size);
+}
+
+static void audio_start_voice(Audio* audio, const AudioCommand& command, uint64_t start)
+{
+    // Take a free voice or steal the one that started first
+    AudioVoice* voice = &audio->voices[0];
+    for (auto& v : audio->voices)
+    {
+        if (!v.active)
+        {
+            voice = &v;
+            break;
+        }
+        if (v.start < voice->start) voice = &v;
+    }
+
+    voice->start = start;
+    voice->loop = command.type == AUDIO_LOOP;
+    voice->end = voice->loop ? UINT64_MAX : start + audio->sounds[command.sound].size();
+    voice->gain = command.gain;
+    voice->sound = command.sound;
+    voice->active = true;
+}
+
+static void audio_apply_command(Audio* audio, const AudioCommand& command)
+{
+    uint64_t start = command.tick * AUDIO_SAMPLES_PER_TICK;
+    if (command.type != AUDIO_STOP)
+    {
+        audio_start_voice(audio, command, start);
+        return;
+    }
+
+    for (auto& voice : audio->voices)
+    {
+        if (voice.active && voice.sound == command.sound)
+        {
+            voice.end = std::min(voice.end, std::max(voice.start, start));
+        }
+    }
+}
+
+// Mixes the samples from audio->samples_mixed on into mix
+static void audio_mix_block(Audio* audio, float* mix, size_t length)
+{
+    uint64_t block_start = audio->samples_mixed;
+    uint64_t block_end = block_start + length;
+
+    // Commands are in tick order. Applying exactly those that start in this
+    // block keeps voice stealing independent of how far ahead the game is.
+    uint64_t head = audio->command_head.load(std::memory_order_relaxed);
+    uint64_t tail = audio->command_tail.load(std::memory_order_acquire);
+    while (head != tail)
+    {
+        const AudioCommand& command = audio->commands[head % AUDIO_QUEUE_SIZE];
+        if (command.tick * AUDIO_SAMPLES_PER_TICK >= block_end) break;
+        audio_apply_command(audio, command);
+        ++head;
+    }
+    audio->command_head.store(head, std::memory_order_release);
+
+    std::fill(mix, mix + length, 0.0f);
+
+    for (auto& voice : audio->voices)
+    {
+        if (!voice.active) continue;
+
+        const std::vector<float>& sound = audio->sounds[voice.sound];
+        uint64_t from = std::max(voice.start, block_start);
+        uint64_t to = std::min(voice.end, block_end);
+
+        // Loops wrap around, so they are mixed in pieces
+        while (from < to)
+        {
+            size_t position = (from - voice.start) % sound.size();
+            size_t count = std::min<uint64_t>(to - from, sound.size() - position);
+            mix_add(mix + (from - block_start), sound.data() + position, count, voice.gain);
+            from += count;
+        }
+
+        if (voice.end <= block_end) voice.active = false;
+    }
+
+    audio->samples_mixed = block_end;
+}
+
+#if defined(INVADERS_PULSEAUDIO)
+static bool audio_device_open(Audio* audio)
+{
+    pa_sample_spec spec;
+    spec.format = PA_SAMPLE_S16LE;
+    spec.rate = AUDIO_SAMPLE_RATE;
+    spec.channels = 1;
+
+    // A short buffer keeps sounds close to their frames, -1 leaves the rest to the server
+    pa_buffer_attr attr;
+    attr.maxlength = uint32_t(-1);
+    attr.tlength = uint32_t(AUDIO_DEVICE_LATENCY * sizeof(int16_t));
+    attr.prebuf = uint32_t(-1);
+    attr.minreq = uint32_t(-1);
+    attr.fragsize = uint32_t(-1);
+
+    int error = 0;
+    audio->device = pa_simple_new(nullptr, "invaders", PA_STREAM_PLAYBACK, nullptr, "sound effects",
+        &spec, nullptr, &attr, &error);
+    if (!audio->device) std::println("Error opening the audio device: {}", pa_strerror(error));
+    return audio->device != nullptr;
+}
+
+static void audio_device_close(Audio* audio)
+{
+    if (!audio->device) return;
+
+    int error = 0;
+    pa_simple_drain(audio->device, &error);
+    pa_simple_free(audio->device);
+    audio->device = nullptr;
+}
+#else
+static bool audio_device_open(Audio*)
+{
+    return false;
+}
+
+static void audio_device_close(Audio*)
+{
+}
+#endif
+
+static void audio_output(Audio* audio, const float* mix, int16_t* pcm, size_t length)
+{
+    if (audio->backend == AUDIO_BACKEND_NULL) return;
+
+    mix_to_pcm(pcm, mix, length);
+
+    if (audio->backend == AUDIO_BACKEND_WAV)
+    {
+        fwrite(pcm, sizeof(int16_t), length, audio->file);
+        return;
+    }
+
+#if defined(INVADERS_PULSEAUDIO)
+    // Blocks while the device's buffer is full, which paces the thread. A lost
+    // device leaves the game silent rather than stopping it.
+    int error = 0;
+    if (audio->device && pa_simple_write(audio->device, pcm, length * sizeof(int16_t), &error) < 0)
+    {
+        pa_simple_free(audio->device);
+        audio->device = nullptr;
+    }
+#endif
+}
+
+static void audio_thread(Audio* audio)
+{
+    float mix[AUDIO_BLOCK_SIZE];
+    int16_t pcm[AUDIO_BLOCK_SIZE];
+
+    for (;;)
+    {
+        uint64_t ticks_done = audio->ticks_done.load(std::memory_order_acquire);
+        uint64_t limit = (ticks_done & ~AUDIO_QUIT) * AUDIO_SAMPLES_PER_TICK;
+
+        if (audio->samples_mixed + AUDIO_BLOCK_SIZE <= limit)
+        {
+            auto start = std::chrono::steady_clock::now();
+            audio_mix_block(audio, mix, AUDIO_BLOCK_SIZE);
+            audio->mix_nanoseconds += std::chrono::nanoseconds(std::chrono::steady_clock::now() - start).count();
+            ++audio->blocks_mixed;
+
+            audio_output(audio, mix, pcm, AUDIO_BLOCK_SIZE);
+            continue;
+        }
+
+        if (ticks_done & AUDIO_QUIT)
+        {
+            // No more ticks follow, so limit is final
+            size_t length = limit - audio->samples_mixed;
+            if (length > 0)
+            {
+                audio_mix_block(audio, mix, length);
+                audio_output(audio, mix, pcm, length);
+            }
+            return;
+        }
+
+        audio->ticks_done.wait(ticks_done, std::memory_order_acquire);
+    }
+}
+
+bool audio_init(Audio* audio, AudioBackend backend, const char* wav_path)
+{
+    audio_synthesize(audio);
+
+    audio->commands = std::make_unique<AudioCommand[]>(AUDIO_QUEUE_SIZE);
+    audio->command_head.store(0, std::memory_order_relaxed);
+    audio->command_tail.store(0, std::memory_order_relaxed);
+    audio->ticks_done.store(0, std::memory_order_relaxed);
+
+    audio->tick = 0;
+    audio->commands_dropped = 0;
+    audio->pending_stops = 0;
+    audio->event_sounds = 0;
+    audio->march_note = 0;
+    audio->next_march = 0;
+    audio->ufo_playing = false;
+
+    for (auto& voice : audio->voices)
+    {
+        voice.active = false;
+    }
+    audio->samples_mixed = 0;
+    audio->blocks_mixed = 0;
+    audio->mix_nanoseconds = 0;
+
+    audio->backend = backend;
+    audio->file = nullptr;
+    audio->device = nullptr;
+    if (backend == AUDIO_BACKEND_WAV)
+    {
+        audio->file = fopen(wav_path, "wb");
+        if (!audio->file) return false;
+        wav_write_header(audio->file, 0);
+    }
+    else if (backend == AUDIO_BACKEND_DEVICE && !audio_device_open(audio))
+    {
+        return false;
+    }
+
+    audio->thread = std::thread(audio_thread, audio);
+    return true;
+}
+
+void audio_shutdown(Audio* audio)
+{
+    audio->ticks_done.fetch_or(AUDIO_QUIT, std::memory_order_release);
+    audio->ticks_done.notify_one();
+    audio->thread.join();
+
+    audio_device_close(audio);
+
+    if (audio->file)
+    {
+        fseek(audio->file, 0, SEEK_SET);
+        wav_write_header(audio->file, uint32_t(audio->samples_mixed));
+        fclose(audio->file);
+        audio->file = nullptr;
+    }
+}
+
+// Returns false if the queue is full
+static bool audio_enqueue(Audio* audio, const AudioCommand& command)
+{
+    uint64_t tail = audio->command_tail.load(std::memory_order_relaxed);
+    if (tail - audio->command_head.load(std::memory_order_acquire) == AUDIO_QUEUE_SIZE) return false;
+
+    audio->commands[tail % AUDIO_QUEUE_SIZE] = command;
+    audio->command_tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Queues the stops that did not fit, keeping their ticks. They go before any
+// later command, so the queue stays in tick order.
+static bool audio_flush_stops(Audio* audio)
+{
+    while (audio->pending_stops)
+    {
+        auto sound = static_cast<SoundId>(std::countr_zero(audio->pending_stops));
+        if (!audio_enqueue(audio, { audio->pending_stop_ticks[sound], 0.0f, AUDIO_STOP, sound })) return false;
+        audio->pending_stops &= audio->pending_stops - 1;
+    }
+    return true;
+}
+
+static void audio_push(Audio* audio, AudioCommandType type, SoundId sound, float gain)
+{
+    if (audio_flush_stops(audio) && audio_enqueue(audio, { audio->tick, gain, type, sound })) return;
+
+    if (type != AUDIO_STOP)
+    {
+        ++audio->commands_dropped;
+        return;
+    }
+
+    // The first of several stops decides when the sound ends
+    if (!(audio->pending_stops & (1u << sound))) audio->pending_stop_ticks[sound] = audio->tick;
+    audio->pending_stops |= 1u << sound;
+}
+
+void audio_play(Audio* audio, SoundId sound, float gain)
+{
+    audio_push(audio, AUDIO_PLAY, sound, gain);
+}
+
+void audio_loop(Audio* audio, SoundId sound, float gain)
+{
+    audio_push(audio, AUDIO_LOOP, sound, gain);
+}
+
+void audio_stop(Audio* audio, SoundId sound)
+{
+    audio_push(audio, AUDIO_STOP, sound, 0.0f);
+}
+
+void audio_emit_events(Audio* audio, const GameEvents& events)
+{
+    for (size_t i = 0; i < events.num_events; ++i)
+    {
+        SoundId sound;
+        switch (events.events[i].type)
+        {
+        case EVENT_SHOT_FIRED: sound = SOUND_SHOT; break;
+        case EVENT_ALIEN_KILLED: sound = SOUND_ALIEN_KILLED; break;
+        case EVENT_LIFE_LOST: sound = SOUND_PLAYER_KILLED; break;
+        case EVENT_UFO_KILLED: sound = SOUND_UFO_KILLED; break;
+        case EVENT_SHOTS_COLLIDED: sound = SOUND_SHOTS_COLLIDED; break;
+        default: continue;
+        }
+
+        // Many shots in one tick still make one sound
+        if (audio->event_sounds & (1u << sound)) continue;
+        audio->event_sounds |= 1u << sound;
+        audio_play(audio, sound);
+    }
+}
+
+void audio_game_sounds(Audio* audio, const Game& game)
+{
+    if (game.ufo.active != audio->ufo_playing)
+    {
+        if (game.ufo.active) audio_loop(audio, SOUND_UFO);
+        else audio_stop(audio, SOUND_UFO);
+        audio->ufo_playing = game.ufo.active;
+    }
+
+    // The march speeds up as the fleet thins out, from every 52 ticks for a
+    // full formation to every 5 for the last alien
+    if (audio->tick >= audio->next_march)
+    {
+        size_t alive = game.num_alive;
+        if (alive > 0)
+        {
+            audio_play(audio, SoundId(SOUND_MARCH_0 + audio->march_note));
+            audio->march_note = (audio->march_note + 1) % 4;
+        }
+        audio->next_march = audio->tick + 5 + 47 * alive / std::max<size_t>(game.num_aliens, 1);
+    }
+}
+
+void audio_end_tick(Audio* audio)
+{
+    audio_flush_stops(audio);
+    audio->event_sounds = 0;
+    audio->ticks_done.store(++audio->tick, std::memory_order_release);
+    audio->ticks_done.notify_one();
+}
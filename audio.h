@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+
+struct pa_simple;
+
+// Sound effects, mixed on a thread of their own.
+//
+// The game thread stamps every sound it starts with the current tick and puts
+// it into a lock-free single producer, single consumer command queue. At the
+// end of each tick it publishes the tick as complete. The audio thread mixes
+// AUDIO_BLOCK_SIZE samples at a time, but only up to the end of the last
+// complete tick, so every sound starts exactly on the sample of its tick and
+// the output does not depend on how the two threads are scheduled.
+//
+// The output goes to a backend: the device backend plays the samples through
+// PulseAudio, if the build has it (CMake option INVADERS_PULSEAUDIO), the null
+// backend throws them away, which is handy for benchmarks, and the WAV backend
+// writes them to a file.
+//
+// A full queue drops new sounds, but never a stop, which is queued as soon as
+// there is room again. Otherwise a looping sound would play forever.
+
+constexpr size_t AUDIO_SAMPLE_RATE = 48000;
+constexpr size_t AUDIO_TICK_RATE = 60;
+constexpr size_t AUDIO_SAMPLES_PER_TICK = AUDIO_SAMPLE_RATE / AUDIO_TICK_RATE;
+constexpr size_t AUDIO_BLOCK_SIZE = 256;
+constexpr size_t AUDIO_MAX_VOICES = 32;
+constexpr size_t AUDIO_QUEUE_SIZE = 1024;
+
+enum SoundId: uint8_t
+{
+    // The four notes of the fleet's march
+    SOUND_MARCH_0 = 0,
+    SOUND_MARCH_1,
+    SOUND_MARCH_2,
+    SOUND_MARCH_3,
+    SOUND_SHOT,
+    SOUND_ALIEN_KILLED,
+    SOUND_PLAYER_KILLED,
+    // Loops while the UFO flies
+    SOUND_UFO,
+    SOUND_UFO_KILLED,
+    SOUND_SHOTS_COLLIDED,
+    SOUND_NUM
+};
+
+enum AudioBackend: uint8_t
+{
+    AUDIO_BACKEND_NULL = 0,
+    AUDIO_BACKEND_WAV,
+    AUDIO_BACKEND_DEVICE
+};
+
+enum AudioCommandType: uint8_t
+{
+    AUDIO_PLAY = 0,
+    AUDIO_LOOP,
+    AUDIO_STOP
+};
+
+struct AudioCommand
+{
+    uint64_t tick;
+    float gain;
+    AudioCommandType type;
+    SoundId sound;
+};
+
+// A playing sound, only touched by the audio thread
+struct AudioVoice
+{
+    // Absolute sample positions
+    uint64_t start;
+    uint64_t end;
+    float gain;
+    SoundId sound;
+    bool loop;
+    bool active;
+};
+
+struct Audio
+{
+    // Mono samples in [-1, 1], read-only once initialized
+    std::vector<float> sounds[SOUND_NUM];
+
+    // Command queue, written by the game thread, read by the audio thread
+    std::unique_ptr<AudioCommand[]> commands;
+    alignas(64) std::atomic<uint64_t> command_head;
+    alignas(64) std::atomic<uint64_t> command_tail;
+    // Ticks before this one are complete, the audio thread waits on it
+    alignas(64) std::atomic<uint64_t> ticks_done;
+
+    // Game thread only
+    uint64_t tick;
+    uint64_t commands_dropped;
+    // Bit i is set if a stop of sound i waits for room in the queue
+    uint32_t pending_stops;
+    uint64_t pending_stop_ticks[SOUND_NUM];
+    // Bit i is set if sound i was started by an event of the current tick
+    uint32_t event_sounds;
+    size_t march_note;
+    uint64_t next_march;
+    bool ufo_playing;
+
+    // Audio thread only
+    AudioVoice voices[AUDIO_MAX_VOICES];
+    uint64_t samples_mixed;
+
+    AudioBackend backend;
+    FILE* file;
+    pa_simple* device;
+    std::thread thread;
+
+    // Written by the audio thread, safe to read once it has stopped
+    uint64_t blocks_mixed;
+    uint64_t mix_nanoseconds;
+};
+
+// Starts the audio thread. The WAV backend writes 16-bit mono to wav_path.
+// Returns false if the output cannot be opened, e.g. the device backend
+// without PulseAudio, and does not start the thread then.
+bool audio_init(Audio* audio, AudioBackend backend, const char* wav_path = nullptr);
+
+// Mixes everything up to the last complete tick, stops the thread and
+// finishes the output
+void audio_shutdown(Audio* audio);
+
+// Starts a sound on the current tick. Looped sounds play until stopped.
+void audio_play(Audio* audio, SoundId sound, float gain = 1.0f);
+
+void audio_loop(Audio* audio, SoundId sound, float gain = 1.0f);
+
+void audio_stop(Audio* audio, SoundId sound);
+
+// Plays the sounds of a batch of events polled from the EventBus
+void audio_emit_events(Audio* audio, const GameEvents& events);
+
+// Plays the march of the fleet and the UFO, which follow the game's state
+void audio_game_sounds(Audio* audio, const Game& game);
+
+// Marks the current tick as complete, so the audio thread can mix it
+void audio_end_tick(Audio* audio);
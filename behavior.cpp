@@ -0,0 +1,147 @@
+#include "behavior.h"
+
+#include <algorithm>
+#include <memory>
+
+constexpr size_t BEHAVIOR_NUM_FRAME_CLASSES = BEHAVIOR_MAX_POOLED_FRAME / BEHAVIOR_FRAME_GRANULARITY;
+constexpr size_t BEHAVIOR_SLAB_SIZE = 64 << 10;
+
+// Free blocks are linked through their first bytes
+struct BehaviorFreeFrame
+{
+    BehaviorFreeFrame* next;
+};
+
+struct BehaviorFramePool
+{
+    BehaviorFreeFrame* free_frames[BEHAVIOR_NUM_FRAME_CLASSES];
+    std::vector<std::unique_ptr<uint8_t[]>> slabs;
+    uint8_t* slab_begin;
+    uint8_t* slab_end;
+};
+
+// Frames are created and destroyed on the thread running the scheduler
+static thread_local BehaviorFramePool frame_pool;
+
+static size_t behavior_frame_class(size_t size)
+{
+    return (size + BEHAVIOR_FRAME_GRANULARITY - 1) / BEHAVIOR_FRAME_GRANULARITY - 1;
+}
+
+void* behavior_frame_alloc(size_t size)
+{
+    if (size > BEHAVIOR_MAX_POOLED_FRAME) return ::operator new(size);
+
+    auto& pool = frame_pool;
+    size_t frame_class = behavior_frame_class(size);
+
+    if (auto frame = pool.free_frames[frame_class])
+    {
+        pool.free_frames[frame_class] = frame->next;
+        return frame;
+    }
+
+    // Carve a new block off the current slab, the rest of a slab too small for
+    // it is simply left unused
+    size_t block_size = (frame_class + 1) * BEHAVIOR_FRAME_GRANULARITY;
+    if (size_t(pool.slab_end - pool.slab_begin) < block_size)
+    {
+        pool.slabs.push_back(std::make_unique<uint8_t[]>(BEHAVIOR_SLAB_SIZE));
+        pool.slab_begin = pool.slabs.back().get();
+        pool.slab_end = pool.slab_begin + BEHAVIOR_SLAB_SIZE;
+    }
+
+    void* frame = pool.slab_begin;
+    pool.slab_begin += block_size;
+    return frame;
+}
+
+void behavior_frame_free(void* frame, size_t size)
+{
+    if (size > BEHAVIOR_MAX_POOLED_FRAME)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    auto& pool = frame_pool;
+    size_t frame_class = behavior_frame_class(size);
+
+    auto free_frame = static_cast<BehaviorFreeFrame*>(frame);
+    free_frame->next = pool.free_frames[frame_class];
+    pool.free_frames[frame_class] = free_frame;
+}
+
+static bool behavior_timer_later(const BehaviorTimer& a, const BehaviorTimer& b)
+{
+    return a.due != b.due ? a.due > b.due : a.order > b.order;
+}
+
+void BehaviorWait::await_suspend(Behavior::Handle handle)
+{
+    auto scheduler = handle.promise().scheduler;
+
+    if (ticks == 1)
+    {
+        scheduler->ready.push_back(handle);
+        return;
+    }
+
+    scheduler->timers.push_back(BehaviorTimer{ scheduler->tick + ticks, scheduler->next_order++, handle });
+    std::push_heap(scheduler->timers.begin(), scheduler->timers.end(), behavior_timer_later);
+}
+
+void behavior_init(BehaviorScheduler* scheduler)
+{
+    scheduler->tick = 0;
+    scheduler->next_order = 0;
+    scheduler->num_behaviors = 0;
+    scheduler->ready.clear();
+    scheduler->running.clear();
+    scheduler->timers.clear();
+}
+
+void behavior_shutdown(BehaviorScheduler* scheduler)
+{
+    for (auto handle : scheduler->ready) handle.destroy();
+    for (auto& timer : scheduler->timers) timer.handle.destroy();
+
+    behavior_init(scheduler);
+}
+
+void behavior_spawn(BehaviorScheduler* scheduler, Behavior behavior)
+{
+    behavior.handle.promise().scheduler = scheduler;
+    scheduler->ready.push_back(behavior.handle);
+    ++scheduler->num_behaviors;
+}
+
+void behavior_tick(BehaviorScheduler* scheduler)
+{
+    ++scheduler->tick;
+
+    // Behaviors waiting for the next tick again go into the emptied ready list
+    auto& running = scheduler->running;
+    running.swap(scheduler->ready);
+
+    auto& timers = scheduler->timers;
+    while (!timers.empty() && timers.front().due <= scheduler->tick)
+    {
+        std::pop_heap(timers.begin(), timers.end(), behavior_timer_later);
+        running.push_back(timers.back().handle);
+        timers.pop_back();
+    }
+
+    for (auto handle : running)
+    {
+        handle.resume();
+
+        if (handle.done())
+        {
+            handle.destroy();
+            --scheduler->num_behaviors;
+        }
+    }
+
+    running.clear();
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <vector>
+
+// Scripted behaviors written as C++20 coroutines, e.g.
+//
+//     Behavior blink(Game* game)
+//     {
+//         while (true)
+//         {
+//             co_await behavior_wait(30);
+//             ...
+//         }
+//     }
+//
+// A BehaviorScheduler resumes every behavior once the ticks it waits for have
+// passed. Behaviors waiting for the next tick sit in a plain list, longer waits
+// in a heap ordered by due tick, so a tick only touches the behaviors that are
+// due. Coroutine frames come from a per-thread pool of fixed size blocks,
+// starting and finishing behaviors does not allocate once the pool has grown.
+
+struct BehaviorScheduler;
+
+// Frames up to this size are pooled, in classes of BEHAVIOR_FRAME_GRANULARITY
+constexpr size_t BEHAVIOR_MAX_POOLED_FRAME = 1024;
+constexpr size_t BEHAVIOR_FRAME_GRANULARITY = 64;
+
+void* behavior_frame_alloc(size_t size);
+
+void behavior_frame_free(void* frame, size_t size);
+
+struct Behavior
+{
+    struct promise_type
+    {
+        BehaviorScheduler* scheduler = nullptr;
+
+        static void* operator new(size_t size) { return behavior_frame_alloc(size); }
+        static void operator delete(void* frame, size_t size) { behavior_frame_free(frame, size); }
+
+        Behavior get_return_object()
+        {
+            return Behavior{ std::coroutine_handle<promise_type>::from_promise(*this) };
+        }
+
+        // Behaviors only run when the scheduler resumes them
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    using Handle = std::coroutine_handle<promise_type>;
+
+    Handle handle;
+};
+
+struct BehaviorTimer
+{
+    uint64_t due;
+    // Breaks ties so behaviors due on the same tick run in the order they waited
+    uint64_t order;
+    Behavior::Handle handle;
+};
+
+struct BehaviorScheduler
+{
+    uint64_t tick;
+    uint64_t next_order;
+    size_t num_behaviors;
+    // Resumed on the next tick
+    std::vector<Behavior::Handle> ready;
+    // Resumed during the current tick
+    std::vector<Behavior::Handle> running;
+    // Min-heap of the behaviors waiting for more than one tick
+    std::vector<BehaviorTimer> timers;
+};
+
+// Suspends the behavior for the given number of ticks, 0 does not suspend
+struct BehaviorWait
+{
+    uint64_t ticks;
+
+    bool await_ready() const noexcept { return ticks == 0; }
+    void await_suspend(Behavior::Handle handle);
+    void await_resume() const noexcept {}
+};
+
+inline BehaviorWait behavior_next_tick()
+{
+    return BehaviorWait{ 1 };
+}
+
+inline BehaviorWait behavior_wait(uint64_t ticks)
+{
+    return BehaviorWait{ ticks };
+}
+
+void behavior_init(BehaviorScheduler* scheduler);
+
+// Destroys the frames of all behaviors that have not finished
+void behavior_shutdown(BehaviorScheduler* scheduler);
+
+// The behavior starts running on the next tick
+void behavior_spawn(BehaviorScheduler* scheduler, Behavior behavior);
+
+// Advances the scheduler by one tick and resumes the due behaviors
+void behavior_tick(BehaviorScheduler* scheduler);
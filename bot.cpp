@@ -0,0 +1,208 @@
+#include "bot.h"
+
+#include <algorithm>
+#include <numeric>
+
+constexpr double BOT_LIFE_COST = 300;
+
+BotConfig bot_default_config()
+{
+    BotConfig config;
+    config.beam_width = 16;
+    config.depth = 30;
+    config.action_ticks = 4;
+    config.discount = 0.97;
+    config.table_bits = 12;
+    return config;
+}
+
+void bot_init(Bot* bot, const BotConfig& config, const GameAssets& assets, JobSystem* jobs,
+    const Game& game)
+{
+    bot->config = config;
+    bot->assets = &assets;
+    bot->jobs = jobs;
+
+    bot->beam = std::vector<BotNode>(config.beam_width);
+    bot->candidates = std::vector<BotNode>(config.beam_width * BOT_NUM_ACTIONS);
+    for (auto& node : bot->beam) node.game = game;
+    for (auto& node : bot->candidates) node.game = game;
+
+    bot->order = std::vector<uint32_t>(bot->candidates.size());
+    bot->table = std::vector<BotTableEntry>(size_t(1) << config.table_bits, BotTableEntry{0, 0});
+    bot->generation = 0;
+    bot->action = BOT_IDLE;
+    bot->action_ticks_left = 0;
+    bot->num_rollouts = 0;
+    bot->num_ticks = 0;
+}
+
+static GameInput bot_action_input(BotAction action, bool first_tick)
+{
+    GameInput input;
+    input.move_dir = action == BOT_LEFT ? -1 : (action == BOT_RIGHT ? 1 : 0);
+    // Like a key press, firing only happens once per action
+    input.fire = action == BOT_FIRE && first_tick;
+    return input;
+}
+
+// Value of the position, not counting the score already made
+static double bot_evaluate(const Game& game, const GameAssets& assets)
+{
+    if (game.player.life == 0) return -1e9;
+
+    // Bullets still in flight only score after the search horizon, so credit
+    // half the points of the alien they are heading for. Without that the
+    // search cannot tell a good shot from a wasted one.
+    double pending = 0;
+    for (size_t bi = 0; bi < game.num_bullets; ++bi)
+    {
+        const auto& bullet = game.bullets[bi];
+        if (bullet.type != BULLET_PLAYER) continue;
+
+        for (const auto& alien : game.aliens)
+        {
+            if (alien.type == ALIEN_DEAD || alien.y < bullet.y) continue;
+
+            const auto& sprite = game_alien_sprite(game, assets, alien.type);
+            if (bullet.x >= alien.x && bullet.x < alien.x + sprite.width)
+            {
+                pending += 5 * (AlienType::N - alien.type);
+                break;
+            }
+        }
+    }
+
+    // Otherwise prefer being in a position to shoot at the nearest alien
+    size_t fire_x = game.player.x + assets.player_sprite.width / 2;
+    size_t distance = game.width;
+    for (const auto& alien : game.aliens)
+    {
+        if (alien.type == ALIEN_DEAD) continue;
+
+        const auto& sprite = game_alien_sprite(game, assets, alien.type);
+        size_t d = 0;
+        if (fire_x < alien.x) d = alien.x - fire_x;
+        else if (fire_x >= alien.x + sprite.width) d = fire_x + 1 - alien.x - sprite.width;
+        distance = std::min(distance, d);
+    }
+
+    return pending - 0.1 * double(distance);
+}
+
+// Returns false if the key was already inserted during the current search
+static bool bot_table_insert(Bot* bot, uint64_t key)
+{
+    size_t mask = bot->table.size() - 1;
+    size_t index = key & mask;
+
+    // Short linear probe, if the neighbourhood is full the state is simply kept
+    for (size_t probe = 0; probe < 8; ++probe)
+    {
+        auto& entry = bot->table[index];
+        if (entry.generation != bot->generation)
+        {
+            entry.key = key;
+            entry.generation = bot->generation;
+            return true;
+        }
+
+        if (entry.key == key) return false;
+
+        index = (index + 1) & mask;
+    }
+
+    return true;
+}
+
+static void bot_search(Bot* bot, const Game& game)
+{
+    const auto& config = bot->config;
+    const auto& assets = *bot->assets;
+
+    // Bumping the generation invalidates the whole transposition table at once
+    ++bot->generation;
+
+    size_t beam_size = 1;
+    bot->beam[0].game = game;
+    bot->beam[0].reward = 0;
+    bot->beam[0].value = 0;
+    bot->beam[0].first_action = BOT_IDLE;
+
+    double discount = 1;
+    for (size_t depth = 0; depth < config.depth; ++depth)
+    {
+        discount *= config.discount;
+        size_t num_candidates = beam_size * BOT_NUM_ACTIONS;
+
+        jobs_parallel_for(bot->jobs, num_candidates, 1, [&](size_t begin, size_t end, size_t)
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                const auto& parent = bot->beam[c / BOT_NUM_ACTIONS];
+                auto& node = bot->candidates[c];
+                auto action = static_cast<BotAction>(c % BOT_NUM_ACTIONS);
+
+                node.game = parent.game;
+                node.first_action = depth == 0 ? action : parent.first_action;
+
+                // The front end's script moves a flying UFO every tick, spawns
+                // cannot be foreseen
+                for (size_t t = 0; t < config.action_ticks && !game_is_over(node.game); ++t)
+                {
+                    game_step(&node.game, assets, bot_action_input(action, t == 0));
+                    game_ufo_move(&node.game, assets);
+                }
+
+                // Points are discounted by how far ahead they are made, otherwise
+                // the bot keeps postponing shots which score within the horizon anyway
+                // A lost life costs about as much as a row of aliens is worth
+                double points = double(node.game.score - parent.game.score) -
+                    BOT_LIFE_COST * double(parent.game.player.life - node.game.player.life);
+                node.reward = parent.reward + discount * points;
+                node.value = node.reward + discount * bot_evaluate(node.game, assets);
+            }
+        });
+
+        bot->num_rollouts += num_candidates;
+        bot->num_ticks += num_candidates * config.action_ticks;
+
+        // Keep the best unique states. Ties are broken by index so the search
+        // does not depend on the number of threads.
+        auto order = bot->order.begin();
+        std::iota(order, order + num_candidates, 0);
+        std::sort(order, order + num_candidates, [&](uint32_t a, uint32_t b)
+        {
+            const auto& na = bot->candidates[a];
+            const auto& nb = bot->candidates[b];
+            return na.value != nb.value ? na.value > nb.value : a < b;
+        });
+
+        beam_size = 0;
+        for (size_t i = 0; i < num_candidates && beam_size < config.beam_width; ++i)
+        {
+            auto& node = bot->candidates[order[i]];
+            uint64_t key = node.game.hash ^ (depth * 0x9e3779b97f4a7c15ull);
+            if (!bot_table_insert(bot, key)) continue;
+
+            // Swapping keeps every node's memory around for the next search
+            std::swap(bot->beam[beam_size++], node);
+        }
+    }
+
+    bot->action = bot->beam[0].first_action;
+}
+
+GameInput bot_next_input(Bot* bot, const Game& game)
+{
+    if (bot->action_ticks_left == 0)
+    {
+        bot_search(bot, game);
+        bot->action_ticks_left = bot->config.action_ticks;
+    }
+
+    bool first_tick = bot->action_ticks_left == bot->config.action_ticks;
+    --bot->action_ticks_left;
+
+    return bot_action_input(bot->action, first_tick);
+}
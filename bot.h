@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets.h"
+#include "game.h"
+#include "jobs.h"
+
+enum BotAction: uint8_t
+{
+    BOT_IDLE = 0,
+    BOT_LEFT,
+    BOT_RIGHT,
+    BOT_FIRE,
+    BOT_NUM_ACTIONS
+};
+
+struct BotConfig
+{
+    // Number of states kept per search depth
+    size_t beam_width;
+    // Number of actions looked ahead, each held for action_ticks ticks
+    size_t depth;
+    size_t action_ticks;
+    // Weight of points made one action later relative to points made now
+    double discount;
+    // log2 of the number of transposition table entries
+    size_t table_bits;
+};
+
+struct BotNode
+{
+    Game game;
+    // Discounted points made along the path, and that plus the estimated value
+    // of the final position
+    double reward;
+    double value;
+    BotAction first_action;
+};
+
+struct BotTableEntry
+{
+    uint64_t key;
+    uint32_t generation;
+};
+
+// Beam search over the player's actions. Every node is a full copy of the game,
+// the candidates of one depth are simulated in parallel and states which were
+// already reached (same Zobrist hash at the same depth) are dropped.
+struct Bot
+{
+    BotConfig config;
+    const GameAssets* assets;
+    JobSystem* jobs;
+    std::vector<BotNode> beam;
+    std::vector<BotNode> candidates;
+    std::vector<uint32_t> order;
+    std::vector<BotTableEntry> table;
+    uint32_t generation;
+    BotAction action;
+    size_t action_ticks_left;
+    // Number of simulated action segments and ticks, for benchmarking
+    uint64_t num_rollouts;
+    uint64_t num_ticks;
+};
+
+BotConfig bot_default_config();
+
+// All nodes are allocated here, from then on the search does not allocate
+void bot_init(Bot* bot, const BotConfig& config, const GameAssets& assets, JobSystem* jobs,
+    const Game& game);
+
+GameInput bot_next_input(Bot* bot, const Game& game);
@@ -0,0 +1,175 @@
+#include "boxes.h"
+
+#include <bit>
+#include <climits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// AVX2 is compiled for this function only and used if the CPU has it
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOXES_AVX2 1
+#include <immintrin.h>
+#endif
+
+using BoxKernel = void (*)(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks);
+
+void box_set_clear(BoxSet* boxes)
+{
+    boxes->count = 0;
+    boxes->x.clear();
+    boxes->y.clear();
+    boxes->width.clear();
+    boxes->height.clear();
+}
+
+void box_set_reserve(BoxSet* boxes, size_t count)
+{
+    size_t size = count + BOX_SET_PADDING;
+    boxes->x.reserve(size);
+    boxes->y.reserve(size);
+    boxes->width.reserve(size);
+    boxes->height.reserve(size);
+}
+
+size_t box_set_add(BoxSet* boxes, int32_t x, int32_t y, int32_t width, int32_t height)
+{
+    if (boxes->count == boxes->x.size())
+    {
+        size_t size = boxes->count + BOX_SET_PADDING;
+        boxes->x.resize(size, INT32_MIN);
+        boxes->y.resize(size, INT32_MIN);
+        boxes->width.resize(size, 0);
+        boxes->height.resize(size, 0);
+    }
+
+    size_t index = boxes->count++;
+    boxes->x[index] = x;
+    boxes->y[index] = y;
+    boxes->width[index] = width;
+    boxes->height[index] = height;
+    return index;
+}
+
+void box_set_remove(BoxSet* boxes, size_t index)
+{
+    // Its right edge is left of everything
+    boxes->x[index] = INT32_MIN;
+    boxes->width[index] = 0;
+}
+
+// Every x86-64 CPU has SSE2, so this is only built for other targets
+#if !defined(__SSE2__)
+static void box_overlaps_scalar(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks)
+{
+    for (size_t i = 0; i < boxes.count; ++i)
+    {
+        bool overlap = x < boxes.x[i] + boxes.width[i] && x + width > boxes.x[i] &&
+            y < boxes.y[i] + boxes.height[i] && y + height > boxes.y[i];
+        masks[i / 64] |= uint64_t(overlap) << (i % 64);
+    }
+}
+#endif
+
+#if defined(__SSE2__)
+static void box_overlaps_sse2(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks)
+{
+    __m128i left = _mm_set1_epi32(x);
+    __m128i right = _mm_set1_epi32(x + width);
+    __m128i bottom = _mm_set1_epi32(y);
+    __m128i top = _mm_set1_epi32(y + height);
+
+    for (size_t i = 0; i < boxes.count; i += 4)
+    {
+        __m128i bx = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&boxes.x[i]));
+        __m128i by = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&boxes.y[i]));
+        __m128i bw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&boxes.width[i]));
+        __m128i bh = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&boxes.height[i]));
+
+        __m128i overlap_x = _mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(bx, bw), left),
+            _mm_cmpgt_epi32(right, bx));
+        __m128i overlap_y = _mm_and_si128(_mm_cmpgt_epi32(_mm_add_epi32(by, bh), bottom),
+            _mm_cmpgt_epi32(top, by));
+
+        uint64_t bits = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(overlap_x, overlap_y)));
+        masks[i / 64] |= bits << (i % 64);
+    }
+}
+#endif
+
+#if defined(BOXES_AVX2)
+__attribute__((target("avx2")))
+static void box_overlaps_avx2(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks)
+{
+    __m256i left = _mm256_set1_epi32(x);
+    __m256i right = _mm256_set1_epi32(x + width);
+    __m256i bottom = _mm256_set1_epi32(y);
+    __m256i top = _mm256_set1_epi32(y + height);
+
+    for (size_t i = 0; i < boxes.count; i += 8)
+    {
+        __m256i bx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&boxes.x[i]));
+        __m256i by = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&boxes.y[i]));
+        __m256i bw = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&boxes.width[i]));
+        __m256i bh = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&boxes.height[i]));
+
+        __m256i overlap_x = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(bx, bw), left),
+            _mm256_cmpgt_epi32(right, bx));
+        __m256i overlap_y = _mm256_and_si256(_mm256_cmpgt_epi32(_mm256_add_epi32(by, bh), bottom),
+            _mm256_cmpgt_epi32(top, by));
+
+        uint64_t bits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(overlap_x, overlap_y)));
+        masks[i / 64] |= bits << (i % 64);
+    }
+}
+#endif
+
+struct BoxKernelChoice
+{
+    BoxKernel kernel;
+    const char* name;
+};
+
+static BoxKernelChoice box_kernel_select()
+{
+#if defined(BOXES_AVX2)
+    if (__builtin_cpu_supports("avx2")) return { box_overlaps_avx2, "avx2" };
+#endif
+#if defined(__SSE2__)
+    return { box_overlaps_sse2, "sse2" };
+#else
+    return { box_overlaps_scalar, "scalar" };
+#endif
+}
+
+static const BoxKernelChoice box_kernel = box_kernel_select();
+
+size_t box_set_overlaps(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks)
+{
+    size_t num_words = box_set_mask_words(boxes.count);
+    for (size_t w = 0; w < num_words; ++w)
+    {
+        masks[w] = 0;
+    }
+
+    // The SIMD kernels run into the padding, whose bits stay clear
+    box_kernel.kernel(boxes, x, y, width, height, masks);
+
+    size_t num_overlaps = 0;
+    for (size_t w = 0; w < num_words; ++w)
+    {
+        num_overlaps += std::popcount(masks[w]);
+    }
+    return num_overlaps;
+}
+
+const char* box_set_kernel_name()
+{
+    return box_kernel.name;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Axis aligned boxes tested against one box many at a time.
+//
+// The boxes are kept as a structure of arrays, so a SIMD register holds the x
+// (or y, width, height) of 4 or 8 boxes and a few compares test all of them.
+// The widest kernel the CPU supports is picked at runtime: AVX2 tests 8 boxes
+// per step, SSE2 4, and a scalar loop is left for other CPUs. Results come back
+// as bitmasks with one bit per box.
+//
+// This is the narrow phase after any broadphase, and for a few hundred boxes
+// it is usually faster than a broadphase on its own.
+
+// The arrays are padded to a multiple of this with boxes that overlap nothing
+constexpr size_t BOX_SET_PADDING = 8;
+
+struct BoxSet
+{
+    size_t count;
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<int32_t> width;
+    std::vector<int32_t> height;
+};
+
+// Words of the mask box_set_overlaps() writes for the given number of boxes
+inline size_t box_set_mask_words(size_t count)
+{
+    return (count + 63) / 64;
+}
+
+void box_set_clear(BoxSet* boxes);
+
+// Makes room for count boxes, adding up to that many does not allocate
+void box_set_reserve(BoxSet* boxes, size_t count);
+
+// Appends a box and returns its index
+size_t box_set_add(BoxSet* boxes, int32_t x, int32_t y, int32_t width, int32_t height);
+
+// Replaces a box by one that overlaps nothing, keeping the indices of the others
+void box_set_remove(BoxSet* boxes, size_t index);
+
+// Sets bit i of masks[i / 64] if box i overlaps the given box, touching edges
+// do not count, and returns the number of overlapping boxes. masks must hold
+// box_set_mask_words(boxes.count) words.
+size_t box_set_overlaps(const BoxSet& boxes, int32_t x, int32_t y, int32_t width, int32_t height,
+    uint64_t* masks);
+
+// The name of the kernel box_set_overlaps() uses on this CPU
+const char* box_set_kernel_name();
@@ -0,0 +1,164 @@
+#include "buffer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+void buffer_clear(Buffer* buffer, uint32_t color)
+{
+    std::fill_n(buffer->data.data(), buffer->width * buffer->height, color);
+    std::fill(buffer->ids.begin(), buffer->ids.end(), 0);
+}
+
+uint64_t buffer_hash(const Buffer& buffer)
+{
+    // FNV-1a over whole pixels rather than bytes, followed by a final avalanche
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < buffer.width * buffer.height; ++i)
+    {
+        hash = (hash ^ buffer.data[i]) * 0x100000001b3ull;
+    }
+
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdull;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void buffer_draw_bitmap(Buffer* buffer, const uint8_t* bitmap, size_t width, size_t height,
+    size_t x, size_t y, uint32_t color, uint32_t id)
+{
+    uint32_t* ids = buffer->ids.empty() ? nullptr : buffer->ids.data();
+
+    // Walk the bitmap row by row, so both it and the buffer are read in order
+    for (size_t yi = 0; yi < height; ++yi)
+    {
+        for (size_t xi = 0; xi < width; ++xi)
+        {
+            size_t sy = height - 1 + y - yi;
+            size_t sx = x + xi;
+
+            if (bitmap[yi * width + xi] &&
+                sy < buffer->height &&
+                sx < buffer->width)
+            {
+                buffer->data[sy * buffer->width + sx] = color;
+                if (ids) ids[sy * buffer->width + sx] = id;
+            }
+        }
+    }
+}
+
+void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite,
+    size_t x, size_t y, uint32_t color, uint32_t id)
+{
+    buffer_draw_bitmap(buffer, sprite.data.data(), sprite.width, sprite.height, x, y, color, id);
+}
+
+void buffer_draw_packed(Buffer* buffer, const uint32_t* rows, size_t width, size_t height,
+    size_t x, size_t y, uint32_t color, uint32_t id)
+{
+    // Columns right of the buffer are masked off once per row instead of per pixel
+    if (x >= buffer->width) return;
+    size_t visible = std::min(width, buffer->width - x);
+    uint32_t column_mask = visible >= 32 ? ~0u : (1u << visible) - 1;
+
+    for (size_t yi = 0; yi < height; ++yi)
+    {
+        size_t sy = height - 1 + y - yi;
+        if (sy >= buffer->height) continue;
+
+        uint32_t* row = buffer->data.data() + sy * buffer->width + x;
+        for (uint32_t bits = rows[yi] & column_mask; bits; bits &= bits - 1)
+        {
+            row[__builtin_ctz(bits)] = color;
+        }
+
+        if (buffer->ids.empty()) continue;
+
+        uint32_t* id_row = buffer->ids.data() + sy * buffer->width + x;
+        for (uint32_t bits = rows[yi] & column_mask; bits; bits &= bits - 1)
+        {
+            id_row[__builtin_ctz(bits)] = id;
+        }
+    }
+}
+
+void buffer_draw_points(Buffer* buffer, const float* x, const float* y, const uint32_t* colors,
+    size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        // Negative coordinates wrap around and fail the bounds check
+        size_t px = size_t(int64_t(std::floor(x[i])));
+        size_t py = size_t(int64_t(std::floor(y[i])));
+
+        if (px < buffer->width && py < buffer->height)
+        {
+            buffer->data[py * buffer->width + px] = colors[i];
+        }
+    }
+}
+
+PackedSprite sprite_pack(const Sprite& sprite)
+{
+    PackedSprite packed;
+    packed.width = sprite.width;
+    packed.height = sprite.height;
+    packed.rows = std::vector<uint32_t>(sprite.height, 0);
+
+    for (size_t yi = 0; yi < sprite.height; ++yi)
+    {
+        for (size_t xi = 0; xi < sprite.width && xi < 32; ++xi)
+        {
+            if (sprite.data[yi * sprite.width + xi]) packed.rows[yi] |= 1u << xi;
+        }
+    }
+
+    return packed;
+}
+
+// We define a new spritesheet containing 65 5x7 ASCII character sprites starting from 'space',
+// which has the value of 32 in ASCII, up to character '`', which has ASCII value 96.
+// Note that we only include uppercase letters and a few special characters.
+void buffer_draw_text(Buffer* buffer, const Sprite& text_spritesheet, const char* text,
+    size_t x, size_t y, uint32_t color)
+{
+    size_t xp = x;
+    size_t stride = text_spritesheet.width * text_spritesheet.height;
+
+    for (auto charp = text; *charp != '\0'; ++charp)
+    {
+        char character = *charp - 32;
+        if (character < 0 || character >= 65) continue;
+
+        buffer_draw_bitmap(buffer, text_spritesheet.data.data() + character * stride,
+            text_spritesheet.width, text_spritesheet.height, xp, y, color);
+        xp += text_spritesheet.width + 1;
+    }
+}
+
+void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
+    size_t x, size_t y, uint32_t color)
+{
+    std::array<uint8_t, 64> digits;
+    size_t num_digits = 0;
+
+    size_t current_number = number;
+    do
+    {
+        digits[num_digits++] = current_number % 10;
+        current_number = current_number / 10;
+    } while (current_number > 0);
+
+    size_t xp = x;
+    size_t stride = number_spritesheet.width * number_spritesheet.height;
+
+    for (size_t i = 0; i < num_digits; ++i)
+    {
+        auto digit = digits[num_digits - i - 1];
+        buffer_draw_bitmap(buffer, number_spritesheet.data.data() + digit * stride,
+            number_spritesheet.width, number_spritesheet.height, xp, y, color);
+        xp += number_spritesheet.width + 1;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Pixels are packed as 0xRRGGBBAA and rows are stored bottom-up, i.e. (0, 0) is
+// the bottom left corner of the screen, which matches the OpenGL texture layout.
+struct Buffer
+{
+    size_t width;
+    size_t height;
+    std::vector<uint32_t> data;
+    // Optional, either empty or one id per pixel in the layout of data. The
+    // sprite drawing functions write the id of what they draw, see game_render().
+    std::vector<uint32_t> ids;
+};
+
+struct Sprite
+{
+    size_t width;
+    size_t height;
+    std::vector<uint8_t> data;
+};
+
+// A 1bpp sprite of at most 32 pixels width. Each row is a word whose bit i is
+// column i, rows are stored top to bottom like in Sprite.
+struct PackedSprite
+{
+    size_t width;
+    size_t height;
+    std::vector<uint32_t> rows;
+};
+
+constexpr uint32_t rgb_to_uint32(uint8_t r, uint8_t g, uint8_t b)
+{
+    return ((r << 24) | (g << 16) | (b << 8) | 255);
+}
+
+// Also resets the ids to 0
+void buffer_clear(Buffer* buffer, uint32_t color);
+
+// A fast 64-bit hash of the pixels, used to compare frames across runs
+uint64_t buffer_hash(const Buffer& buffer);
+
+// Draws a width x height bitmap of 0/1 bytes, e.g. a single glyph of a spritesheet,
+// without having to copy it into a Sprite first.
+void buffer_draw_bitmap(Buffer* buffer, const uint8_t* bitmap, size_t width, size_t height,
+    size_t x, size_t y, uint32_t color, uint32_t id = 0);
+
+void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite,
+    size_t x, size_t y, uint32_t color, uint32_t id = 0);
+
+// Draws packed rows, only visiting the set bits of each row
+void buffer_draw_packed(Buffer* buffer, const uint32_t* rows, size_t width, size_t height,
+    size_t x, size_t y, uint32_t color, uint32_t id = 0);
+
+// Plots single pixels at the given positions, points off screen are skipped
+void buffer_draw_points(Buffer* buffer, const float* x, const float* y, const uint32_t* colors,
+    size_t count);
+
+PackedSprite sprite_pack(const Sprite& sprite);
+
+void buffer_draw_text(Buffer* buffer, const Sprite& text_spritesheet, const char* text,
+    size_t x, size_t y, uint32_t color);
+
+void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
+    size_t x, size_t y, uint32_t color);
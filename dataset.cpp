@@ -0,0 +1,391 @@
+// Exports rendered frames of headless games, labeled with the bounding box and
+// class of every sprite on screen, for training vision models.
+//
+// Several threads play games with random policies and fill chunks of frames,
+// while a separate thread writes the finished chunks to disk. Chunk buffers are
+// recycled, so once running nothing is allocated.
+//
+// File layout, all values little endian:
+//
+//   header:  u32 magic "IVDS", u32 version, u32 width, u32 height,
+//            u32 pixel format (1 = 8-bit luminance, rows bottom-up)
+//   chunks:  u32 magic "IVDC", u32 num_frames, u32 num_boxes, u32 reserved,
+//            u64 payload size in bytes, followed by the columns
+//              u64 seed[num_frames]           seed of the game the frame is from
+//              u32 tick[num_frames]           tick within that game
+//              u32 box_begin[num_frames + 1]  frame i owns boxes [box_begin[i], box_begin[i + 1])
+//              u8  pixels[num_frames][height][width]
+//              u16 box_x[num_boxes], box_y[num_boxes], box_width[num_boxes], box_height[num_boxes]
+//              u8  box_class[num_boxes]       an EntityClass
+//
+// Chunks are written in the order they are completed, so frames of different
+// games are interleaved; the seed and tick columns identify each frame.
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <print>
+#include <thread>
+#include <vector>
+
+#include "assets.h"
+#include "buffer.h"
+#include "game.h"
+#include "policy.h"
+
+constexpr uint32_t DATASET_MAGIC = 0x53445649;  // "IVDS"
+constexpr uint32_t DATASET_CHUNK_MAGIC = 0x43445649;  // "IVDC"
+constexpr uint32_t DATASET_VERSION = 1;
+constexpr uint32_t DATASET_PIXELS_LUMINANCE8 = 1;
+
+struct DatasetConfig
+{
+    const char* path;
+    size_t num_frames;
+    size_t num_threads;
+    size_t chunk_frames;
+    size_t frame_every;
+    size_t max_ticks;
+    uint64_t seed;
+};
+
+struct DatasetChunk
+{
+    size_t num_frames;
+    size_t num_boxes;
+    std::vector<uint64_t> seed;
+    std::vector<uint32_t> tick;
+    std::vector<uint32_t> box_begin;
+    std::vector<uint8_t> pixels;
+    std::vector<uint16_t> box_x;
+    std::vector<uint16_t> box_y;
+    std::vector<uint16_t> box_width;
+    std::vector<uint16_t> box_height;
+    std::vector<uint8_t> box_class;
+};
+
+// A blocking stack of chunk pointers, sized for all chunks up front
+struct ChunkQueue
+{
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<DatasetChunk*> chunks;
+    size_t producers_left;
+};
+
+void chunk_queue_push(ChunkQueue* queue, DatasetChunk* chunk)
+{
+    {
+        std::lock_guard lock(queue->mutex);
+        queue->chunks.push_back(chunk);
+    }
+    queue->ready.notify_one();
+}
+
+// Returns nullptr once the queue is empty and no producer is left
+DatasetChunk* chunk_queue_pop(ChunkQueue* queue)
+{
+    std::unique_lock lock(queue->mutex);
+    queue->ready.wait(lock, [&] { return !queue->chunks.empty() || queue->producers_left == 0; });
+    if (queue->chunks.empty()) return nullptr;
+
+    auto chunk = queue->chunks.back();
+    queue->chunks.pop_back();
+    return chunk;
+}
+
+void chunk_queue_producer_done(ChunkQueue* queue)
+{
+    {
+        std::lock_guard lock(queue->mutex);
+        --queue->producers_left;
+    }
+    queue->ready.notify_all();
+}
+
+void dataset_chunk_init(DatasetChunk* chunk, size_t chunk_frames, size_t frame_pixels, size_t max_boxes)
+{
+    chunk->num_frames = 0;
+    chunk->num_boxes = 0;
+    chunk->seed = std::vector<uint64_t>(chunk_frames);
+    chunk->tick = std::vector<uint32_t>(chunk_frames);
+    chunk->box_begin = std::vector<uint32_t>(chunk_frames + 1);
+    chunk->pixels = std::vector<uint8_t>(chunk_frames * frame_pixels);
+    chunk->box_x = std::vector<uint16_t>(chunk_frames * max_boxes);
+    chunk->box_y = std::vector<uint16_t>(chunk_frames * max_boxes);
+    chunk->box_width = std::vector<uint16_t>(chunk_frames * max_boxes);
+    chunk->box_height = std::vector<uint16_t>(chunk_frames * max_boxes);
+    chunk->box_class = std::vector<uint8_t>(chunk_frames * max_boxes);
+}
+
+struct DatasetShared
+{
+    const DatasetConfig* config;
+    const GameAssets* assets;
+    ChunkQueue free_chunks;
+    ChunkQueue full_chunks;
+    std::atomic<size_t> next_frame;
+    std::atomic<uint64_t> next_game;
+};
+
+void dataset_producer(DatasetShared* shared)
+{
+    const auto& config = *shared->config;
+    const auto& assets = *shared->assets;
+
+    Game game;
+    game_init(&game, assets, game_default_config(), 0);
+
+    Buffer buffer;
+    buffer.width = game.width;
+    buffer.height = game.height;
+    buffer.data = std::vector<uint32_t>(buffer.width * buffer.height);
+
+    size_t max_boxes = game.num_aliens + game.max_bullets + GAME_NUM_SHIELDS + 2;
+    std::vector<EntityBox> boxes(max_boxes);
+
+    RandomPolicy policy;
+    uint64_t seed = 0;
+    size_t tick = config.max_ticks;
+
+    bool done = false;
+    while (!done)
+    {
+        auto chunk = chunk_queue_pop(&shared->free_chunks);
+        chunk->num_frames = 0;
+        chunk->num_boxes = 0;
+        chunk->box_begin[0] = 0;
+
+        while (chunk->num_frames < config.chunk_frames)
+        {
+            if (shared->next_frame.fetch_add(1, std::memory_order_relaxed) >= config.num_frames)
+            {
+                done = true;
+                break;
+            }
+
+            // Advance to the next sampled frame, starting a new game when needed
+            for (size_t i = 0; i < config.frame_every; ++i)
+            {
+                if (tick >= config.max_ticks || game_is_over(game))
+                {
+                    seed = config.seed + shared->next_game.fetch_add(1, std::memory_order_relaxed);
+                    game_init(&game, assets, game_default_config(), seed);
+                    random_policy_init(&policy, seed);
+                    tick = 0;
+                }
+
+                game_step(&game, assets, random_policy_next(&policy));
+                ++tick;
+            }
+
+            game_render(game, assets, &buffer);
+
+            size_t frame = chunk->num_frames++;
+            chunk->seed[frame] = seed;
+            chunk->tick[frame] = tick;
+
+            auto pixels = chunk->pixels.data() + frame * buffer.width * buffer.height;
+            for (size_t i = 0; i < buffer.width * buffer.height; ++i)
+            {
+                uint32_t color = buffer.data[i];
+                uint32_t r = color >> 24, g = (color >> 16) & 0xff, b = (color >> 8) & 0xff;
+                pixels[i] = (r * 77 + g * 150 + b * 29) >> 8;
+            }
+
+            size_t num_boxes = game_entity_boxes(game, assets, boxes.data(), max_boxes);
+            for (size_t bi = 0; bi < num_boxes; ++bi)
+            {
+                size_t index = chunk->num_boxes++;
+                chunk->box_x[index] = boxes[bi].x;
+                chunk->box_y[index] = boxes[bi].y;
+                chunk->box_width[index] = boxes[bi].width;
+                chunk->box_height[index] = boxes[bi].height;
+                chunk->box_class[index] = boxes[bi].type;
+            }
+            chunk->box_begin[frame + 1] = chunk->num_boxes;
+        }
+
+        if (chunk->num_frames > 0) chunk_queue_push(&shared->full_chunks, chunk);
+        else chunk_queue_push(&shared->free_chunks, chunk);
+    }
+
+    chunk_queue_producer_done(&shared->full_chunks);
+}
+
+template <typename T>
+bool write_column(FILE* file, const std::vector<T>& column, size_t count)
+{
+    return std::fwrite(column.data(), sizeof(T), count, file) == count;
+}
+
+bool dataset_write_chunk(FILE* file, const DatasetChunk& chunk, size_t frame_pixels)
+{
+    uint32_t header[4] = {
+        DATASET_CHUNK_MAGIC, uint32_t(chunk.num_frames), uint32_t(chunk.num_boxes), 0
+    };
+    uint64_t payload_size =
+        chunk.num_frames * (sizeof(uint64_t) + sizeof(uint32_t) + sizeof(uint32_t) + frame_pixels) +
+        sizeof(uint32_t) +
+        chunk.num_boxes * (4 * sizeof(uint16_t) + sizeof(uint8_t));
+
+    return std::fwrite(header, sizeof(header), 1, file) == 1 &&
+        std::fwrite(&payload_size, sizeof(payload_size), 1, file) == 1 &&
+        write_column(file, chunk.seed, chunk.num_frames) &&
+        write_column(file, chunk.tick, chunk.num_frames) &&
+        write_column(file, chunk.box_begin, chunk.num_frames + 1) &&
+        write_column(file, chunk.pixels, chunk.num_frames * frame_pixels) &&
+        write_column(file, chunk.box_x, chunk.num_boxes) &&
+        write_column(file, chunk.box_y, chunk.num_boxes) &&
+        write_column(file, chunk.box_width, chunk.num_boxes) &&
+        write_column(file, chunk.box_height, chunk.num_boxes) &&
+        write_column(file, chunk.box_class, chunk.num_boxes);
+}
+
+void print_usage()
+{
+    std::println("Usage: invaders_dataset --out FILE [options]");
+    std::println("  --frames N        number of frames to export (default: 100000)");
+    std::println("  --threads T       number of rendering threads (default: number of CPUs - 1)");
+    std::println("  --chunk-frames C  frames per chunk (default: 256)");
+    std::println("  --frame-every F   export every F-th tick (default: 4)");
+    std::println("  --ticks T         maximum ticks per game (default: 10000)");
+    std::println("  --seed S          seed of the first game (default: 1)");
+}
+
+int main(int argc, char** argv)
+{
+    size_t num_cpus = std::thread::hardware_concurrency();
+
+    DatasetConfig config;
+    config.path = nullptr;
+    config.num_frames = 100000;
+    config.num_threads = num_cpus > 1 ? num_cpus - 1 : 1;
+    config.chunk_frames = 256;
+    config.frame_every = 4;
+    config.max_ticks = 10000;
+    config.seed = 1;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (!std::strcmp(argv[i], "--out") && has_value)
+            config.path = argv[++i];
+        else if (!std::strcmp(argv[i], "--frames") && has_value)
+            config.num_frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--threads") && has_value)
+            config.num_threads = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--chunk-frames") && has_value)
+            config.chunk_frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--frame-every") && has_value)
+            config.frame_every = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--ticks") && has_value)
+            config.max_ticks = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--seed") && has_value)
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        else
+        {
+            print_usage();
+            return -1;
+        }
+    }
+
+    if (!config.path || !config.num_threads || !config.chunk_frames || !config.frame_every)
+    {
+        print_usage();
+        return -1;
+    }
+
+    FILE* file = std::fopen(config.path, "wb");
+    if (!file)
+    {
+        std::println("Error opening {}: {}", config.path, std::strerror(errno));
+        return -1;
+    }
+
+    GameAssets assets;
+    assets_init(&assets);
+
+    Game game;
+    game_init(&game, assets, game_default_config(), 0);
+    size_t frame_pixels = game.width * game.height;
+    size_t max_boxes = game.num_aliens + game.max_bullets + GAME_NUM_SHIELDS + 2;
+
+    uint32_t header[5] = {
+        DATASET_MAGIC, DATASET_VERSION, uint32_t(game.width), uint32_t(game.height),
+        DATASET_PIXELS_LUMINANCE8
+    };
+    if (std::fwrite(header, sizeof(header), 1, file) != 1)
+    {
+        std::fclose(file);
+        std::println("Error writing {}", config.path);
+        return -1;
+    }
+
+    // Two chunks per producer, so each can fill one while the other is written
+    size_t num_chunks = 2 * config.num_threads;
+    std::vector<DatasetChunk> chunks(num_chunks);
+
+    DatasetShared shared;
+    shared.config = &config;
+    shared.assets = &assets;
+    shared.next_frame = 0;
+    shared.next_game = 0;
+    shared.free_chunks.chunks.reserve(num_chunks);
+    // The writer hands every chunk back, so the free list never runs dry for good
+    shared.free_chunks.producers_left = 1;
+    shared.full_chunks.chunks.reserve(num_chunks);
+    shared.full_chunks.producers_left = config.num_threads;
+
+    for (auto& chunk : chunks)
+    {
+        dataset_chunk_init(&chunk, config.chunk_frames, frame_pixels, max_boxes);
+        shared.free_chunks.chunks.push_back(&chunk);
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> producers;
+    for (size_t i = 0; i < config.num_threads; ++i)
+    {
+        producers.emplace_back(dataset_producer, &shared);
+    }
+
+    // The main thread is the writer
+    bool write_ok = true;
+    size_t frames_written = 0, boxes_written = 0;
+    while (auto chunk = chunk_queue_pop(&shared.full_chunks))
+    {
+        write_ok = write_ok && dataset_write_chunk(file, *chunk, frame_pixels);
+        frames_written += chunk->num_frames;
+        boxes_written += chunk->num_boxes;
+        chunk_queue_push(&shared.free_chunks, chunk);
+    }
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    write_ok = std::fclose(file) == 0 && write_ok;
+
+    if (!write_ok)
+    {
+        std::println("Error writing {}", config.path);
+        return -1;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    std::println("{} frames, {} boxes, {} games in {:.2f} s: {:.0f} frames/s",
+        frames_written, boxes_written, shared.next_game.load(), elapsed.count(),
+        frames_written / elapsed.count());
+
+    return 0;
+}
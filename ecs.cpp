@@ -0,0 +1,222 @@
+#include "ecs.h"
+
+#include <cstring>
+#include <new>
+
+static size_t ecs_align(size_t size)
+{
+    return (size + ECS_ALIGNMENT - 1) & ~(ECS_ALIGNMENT - 1);
+}
+
+// Bytes a chunk of the archetype needs for capacity entities
+static size_t ecs_chunk_layout(EcsArchetype* archetype, size_t capacity)
+{
+    size_t offset = 0;
+    for (auto component : archetype->components)
+    {
+        archetype->offsets[component] = offset;
+        offset += ecs_align(capacity * ecs_component_sizes[component]);
+    }
+
+    archetype->entity_offset = offset;
+    return offset + capacity * sizeof(EcsEntity);
+}
+
+static uint32_t ecs_archetype(EcsWorld* world, uint64_t mask)
+{
+    if (auto it = world->archetype_index.find(mask); it != world->archetype_index.end())
+    {
+        return it->second;
+    }
+
+    EcsArchetype archetype;
+    archetype.mask = mask;
+    archetype.num_entities = 0;
+
+    size_t entity_size = sizeof(EcsEntity);
+    for (size_t component = 0; component < ECS_MAX_COMPONENTS; ++component)
+    {
+        if (!(mask & (uint64_t(1) << component))) continue;
+
+        archetype.components.push_back(component);
+        entity_size += ecs_component_sizes[component];
+    }
+
+    // Start from the unpadded estimate and shrink until the arrays fit
+    archetype.capacity = ECS_CHUNK_SIZE / entity_size;
+    while (archetype.capacity > 0 && ecs_chunk_layout(&archetype, archetype.capacity) > ECS_CHUNK_SIZE)
+    {
+        --archetype.capacity;
+    }
+    archetype.chunk_size = ECS_CHUNK_SIZE;
+
+    if (archetype.capacity == 0)
+    {
+        archetype.capacity = 1;
+        archetype.chunk_size = ecs_chunk_layout(&archetype, 1);
+    }
+
+    uint32_t index = world->archetypes.size();
+    world->archetypes.push_back(std::move(archetype));
+    world->archetype_index.emplace(mask, index);
+    return index;
+}
+
+// Appends a row to the archetype, the chunks are kept full except for the last one
+static EcsLocation ecs_push_row(EcsWorld* world, uint32_t archetype_index, EcsEntity entity)
+{
+    auto& archetype = world->archetypes[archetype_index];
+
+    size_t chunk_index = archetype.num_entities / archetype.capacity;
+    if (chunk_index == archetype.chunks.size())
+    {
+        EcsChunk chunk;
+        chunk.count = 0;
+        chunk.data = static_cast<uint8_t*>(
+            ::operator new(archetype.chunk_size, std::align_val_t(ECS_ALIGNMENT)));
+        archetype.chunks.push_back(chunk);
+    }
+
+    auto& chunk = archetype.chunks[chunk_index];
+    size_t row = chunk.count++;
+    ++archetype.num_entities;
+    ecs_chunk_entities(archetype, chunk)[row] = entity;
+
+    return EcsLocation{ archetype_index, uint32_t(chunk_index), uint32_t(row), entity.generation };
+}
+
+// Fills the row's hole with the archetype's last entity
+static void ecs_remove_row(EcsWorld* world, uint32_t archetype_index, uint32_t chunk_index, uint32_t row)
+{
+    auto& archetype = world->archetypes[archetype_index];
+
+    size_t last = archetype.num_entities - 1;
+    size_t last_chunk = last / archetype.capacity;
+    size_t last_row = last % archetype.capacity;
+
+    if (last_chunk != chunk_index || last_row != row)
+    {
+        auto& dst = archetype.chunks[chunk_index];
+        auto& src = archetype.chunks[last_chunk];
+
+        for (auto component : archetype.components)
+        {
+            size_t size = ecs_component_sizes[component];
+            size_t offset = archetype.offsets[component];
+            std::memcpy(dst.data + offset + row * size, src.data + offset + last_row * size, size);
+        }
+
+        EcsEntity moved = ecs_chunk_entities(archetype, src)[last_row];
+        ecs_chunk_entities(archetype, dst)[row] = moved;
+        world->locations[moved.index].chunk = chunk_index;
+        world->locations[moved.index].row = row;
+    }
+
+    --archetype.chunks[last_chunk].count;
+    --archetype.num_entities;
+}
+
+void ecs_init(EcsWorld* world)
+{
+    world->archetypes.clear();
+    world->archetype_index.clear();
+    world->locations.clear();
+    world->free_entities.clear();
+    world->num_entities = 0;
+}
+
+void ecs_shutdown(EcsWorld* world)
+{
+    for (auto& archetype : world->archetypes)
+    {
+        for (auto& chunk : archetype.chunks)
+        {
+            ::operator delete(chunk.data, std::align_val_t(ECS_ALIGNMENT));
+        }
+    }
+
+    ecs_init(world);
+}
+
+EcsEntity ecs_create_entity(EcsWorld* world, uint64_t mask)
+{
+    EcsEntity entity;
+    if (!world->free_entities.empty())
+    {
+        entity.index = world->free_entities.back();
+        entity.generation = world->locations[entity.index].generation;
+        world->free_entities.pop_back();
+    }
+    else
+    {
+        entity.index = world->locations.size();
+        entity.generation = 0;
+        world->locations.emplace_back();
+    }
+
+    world->locations[entity.index] = ecs_push_row(world, ecs_archetype(world, mask), entity);
+    ++world->num_entities;
+    return entity;
+}
+
+bool ecs_alive(const EcsWorld& world, EcsEntity entity)
+{
+    return entity.index < world.locations.size() &&
+        world.locations[entity.index].generation == entity.generation &&
+        world.locations[entity.index].archetype != UINT32_MAX;
+}
+
+void ecs_destroy(EcsWorld* world, EcsEntity entity)
+{
+    if (!ecs_alive(*world, entity)) return;
+
+    auto& location = world->locations[entity.index];
+    ecs_remove_row(world, location.archetype, location.chunk, location.row);
+
+    // Bumping the generation invalidates all copies of the entity
+    location.archetype = UINT32_MAX;
+    ++location.generation;
+    world->free_entities.push_back(entity.index);
+    --world->num_entities;
+}
+
+void ecs_set_mask(EcsWorld* world, EcsEntity entity, uint64_t mask)
+{
+    if (!ecs_alive(*world, entity)) return;
+
+    auto old_location = world->locations[entity.index];
+    if (world->archetypes[old_location.archetype].mask == mask) return;
+
+    // May add an archetype, so look up references to archetypes afterwards
+    uint32_t archetype_index = ecs_archetype(world, mask);
+    auto new_location = ecs_push_row(world, archetype_index, entity);
+
+    const auto& src_archetype = world->archetypes[old_location.archetype];
+    const auto& dst_archetype = world->archetypes[archetype_index];
+    const auto& src = src_archetype.chunks[old_location.chunk];
+    const auto& dst = dst_archetype.chunks[new_location.chunk];
+
+    for (auto component : dst_archetype.components)
+    {
+        if (!(src_archetype.mask & (uint64_t(1) << component))) continue;
+
+        size_t size = ecs_component_sizes[component];
+        std::memcpy(dst.data + dst_archetype.offsets[component] + new_location.row * size,
+            src.data + src_archetype.offsets[component] + old_location.row * size, size);
+    }
+
+    ecs_remove_row(world, old_location.archetype, old_location.chunk, old_location.row);
+    world->locations[entity.index] = new_location;
+}
+
+void* ecs_component(const EcsWorld& world, EcsEntity entity, size_t component)
+{
+    if (!ecs_alive(world, entity)) return nullptr;
+
+    const auto& location = world.locations[entity.index];
+    const auto& archetype = world.archetypes[location.archetype];
+    if (!(archetype.mask & (uint64_t(1) << component))) return nullptr;
+
+    const auto& chunk = archetype.chunks[location.chunk];
+    return chunk.data + archetype.offsets[component] + location.row * ecs_component_sizes[component];
+}
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "jobs.h"
+
+// A small archetype based entity component system.
+//
+// All entities with the same set of components share an archetype, which
+// stores them in fixed size chunks. Each chunk holds one 64-byte aligned array
+// per component, so a query only walks contiguous arrays of the components it
+// asks for, no matter how many other kinds of entities exist.
+//
+// Components are plain structs. They are moved with memcpy when an entity is
+// destroyed or changes its set of components, so they must be trivially
+// copyable. Entities must not be created, destroyed or changed while a query
+// is running; collect them and apply the changes afterwards.
+
+constexpr size_t ECS_MAX_COMPONENTS = 64;
+constexpr size_t ECS_CHUNK_SIZE = 16 << 10;
+constexpr size_t ECS_ALIGNMENT = 64;
+
+// The generation tells a destroyed entity apart from a later one reusing its slot
+struct EcsEntity
+{
+    uint32_t index;
+    uint32_t generation;
+};
+
+struct EcsChunk
+{
+    size_t count;
+    uint8_t* data;
+};
+
+struct EcsArchetype
+{
+    uint64_t mask;
+    // Entities per chunk, and the bytes of a chunk. That is ECS_CHUNK_SIZE
+    // unless a single entity does not fit, its chunks then hold one entity.
+    size_t capacity;
+    size_t chunk_size;
+    size_t num_entities;
+    std::vector<uint8_t> components;
+    // Byte offset of each component's array within a chunk, by component id
+    size_t offsets[ECS_MAX_COMPONENTS];
+    size_t entity_offset;
+    std::vector<EcsChunk> chunks;
+};
+
+struct EcsLocation
+{
+    uint32_t archetype;
+    uint32_t chunk;
+    uint32_t row;
+    uint32_t generation;
+};
+
+struct EcsWorld
+{
+    std::vector<EcsArchetype> archetypes;
+    std::unordered_map<uint64_t, uint32_t> archetype_index;
+    // By entity index, the location of every entity ever created
+    std::vector<EcsLocation> locations;
+    std::vector<uint32_t> free_entities;
+    size_t num_entities;
+    // Scratch space of ecs_parallel_each()
+    std::vector<std::pair<uint32_t, uint32_t>> query_chunks;
+};
+
+// Component ids are handed out on first use and shared by all worlds
+inline std::atomic<size_t> ecs_num_components{0};
+inline size_t ecs_component_sizes[ECS_MAX_COMPONENTS];
+
+template <typename T>
+size_t ecs_component_id()
+{
+    static_assert(std::is_trivially_copyable_v<T>, "Components are moved with memcpy");
+    static_assert(alignof(T) <= ECS_ALIGNMENT, "Component arrays are only 64-byte aligned");
+
+    static const size_t id = []
+    {
+        size_t id = ecs_num_components++;
+        if (id >= ECS_MAX_COMPONENTS) std::abort();
+        ecs_component_sizes[id] = sizeof(T);
+        return id;
+    }();
+    return id;
+}
+
+template <typename... Ts>
+uint64_t ecs_mask()
+{
+    return ((uint64_t(1) << ecs_component_id<Ts>()) | ... | uint64_t(0));
+}
+
+void ecs_init(EcsWorld* world);
+
+void ecs_shutdown(EcsWorld* world);
+
+// Creates an entity with the components of mask, left uninitialized
+EcsEntity ecs_create_entity(EcsWorld* world, uint64_t mask);
+
+void ecs_destroy(EcsWorld* world, EcsEntity entity);
+
+bool ecs_alive(const EcsWorld& world, EcsEntity entity);
+
+// Moves an entity to the archetype of mask, keeping the components both share
+void ecs_set_mask(EcsWorld* world, EcsEntity entity, uint64_t mask);
+
+// Returns nullptr if the entity is dead or lacks the component
+void* ecs_component(const EcsWorld& world, EcsEntity entity, size_t component);
+
+inline EcsEntity* ecs_chunk_entities(const EcsArchetype& archetype, const EcsChunk& chunk)
+{
+    return reinterpret_cast<EcsEntity*>(chunk.data + archetype.entity_offset);
+}
+
+template <typename T>
+T* ecs_chunk_array(const EcsArchetype& archetype, const EcsChunk& chunk)
+{
+    return reinterpret_cast<T*>(chunk.data + archetype.offsets[ecs_component_id<T>()]);
+}
+
+template <typename... Ts>
+EcsEntity ecs_create(EcsWorld* world, const Ts&... components)
+{
+    EcsEntity entity = ecs_create_entity(world, ecs_mask<Ts...>());
+    ((*static_cast<Ts*>(ecs_component(*world, entity, ecs_component_id<Ts>())) = components), ...);
+    return entity;
+}
+
+template <typename T>
+T* ecs_get(EcsWorld* world, EcsEntity entity)
+{
+    return static_cast<T*>(ecs_component(*world, entity, ecs_component_id<T>()));
+}
+
+template <typename T>
+const T* ecs_get(const EcsWorld& world, EcsEntity entity)
+{
+    return static_cast<const T*>(ecs_component(world, entity, ecs_component_id<T>()));
+}
+
+template <typename T>
+void ecs_add(EcsWorld* world, EcsEntity entity, const T& component)
+{
+    auto location = world->locations[entity.index];
+    ecs_set_mask(world, entity, world->archetypes[location.archetype].mask | ecs_mask<T>());
+    *ecs_get<T>(world, entity) = component;
+}
+
+template <typename T>
+void ecs_remove(EcsWorld* world, EcsEntity entity)
+{
+    auto location = world->locations[entity.index];
+    ecs_set_mask(world, entity, world->archetypes[location.archetype].mask & ~ecs_mask<T>());
+}
+
+// Calls f(count, entities, Ts* arrays...) for every chunk of every archetype
+// that has all of Ts
+template <typename... Ts, typename F>
+void ecs_each_chunk(EcsWorld* world, F&& f)
+{
+    uint64_t mask = ecs_mask<Ts...>();
+    for (auto& archetype : world->archetypes)
+    {
+        if ((archetype.mask & mask) != mask) continue;
+
+        for (auto& chunk : archetype.chunks)
+        {
+            if (chunk.count == 0) continue;
+            f(chunk.count, ecs_chunk_entities(archetype, chunk), ecs_chunk_array<Ts>(archetype, chunk)...);
+        }
+    }
+}
+
+template <typename... Ts, typename F>
+void ecs_each_chunk(const EcsWorld& world, F&& f)
+{
+    uint64_t mask = ecs_mask<Ts...>();
+    for (const auto& archetype : world.archetypes)
+    {
+        if ((archetype.mask & mask) != mask) continue;
+
+        for (const auto& chunk : archetype.chunks)
+        {
+            if (chunk.count == 0) continue;
+            f(chunk.count, static_cast<const EcsEntity*>(ecs_chunk_entities(archetype, chunk)),
+                static_cast<const Ts*>(ecs_chunk_array<Ts>(archetype, chunk))...);
+        }
+    }
+}
+
+// Calls f(entity, Ts& components...) for every entity that has all of Ts
+template <typename... Ts, typename F>
+void ecs_each(EcsWorld* world, F&& f)
+{
+    ecs_each_chunk<Ts...>(world, [&](size_t count, EcsEntity* entities, Ts*... arrays)
+    {
+        for (size_t i = 0; i < count; ++i) f(entities[i], arrays[i]...);
+    });
+}
+
+template <typename... Ts, typename F>
+void ecs_each(const EcsWorld& world, F&& f)
+{
+    ecs_each_chunk<Ts...>(world, [&](size_t count, const EcsEntity* entities, const Ts*... arrays)
+    {
+        for (size_t i = 0; i < count; ++i) f(entities[i], arrays[i]...);
+    });
+}
+
+// Like ecs_each(), with the matching chunks spread over the job system. f runs
+// concurrently for entities of different chunks.
+template <typename... Ts, typename F>
+void ecs_parallel_each(EcsWorld* world, JobSystem* jobs, F&& f)
+{
+    uint64_t mask = ecs_mask<Ts...>();
+    auto& query_chunks = world->query_chunks;
+    query_chunks.clear();
+
+    for (uint32_t a = 0; a < world->archetypes.size(); ++a)
+    {
+        const auto& archetype = world->archetypes[a];
+        if ((archetype.mask & mask) != mask) continue;
+
+        for (uint32_t c = 0; c < archetype.chunks.size(); ++c)
+        {
+            if (archetype.chunks[c].count) query_chunks.emplace_back(a, c);
+        }
+    }
+
+    jobs_parallel_for(jobs, query_chunks.size(), 1, [&](size_t begin, size_t end, size_t)
+    {
+        for (size_t q = begin; q < end; ++q)
+        {
+            const auto& archetype = world->archetypes[query_chunks[q].first];
+            const auto& chunk = archetype.chunks[query_chunks[q].second];
+
+            auto run = [&](EcsEntity* entities, Ts*... arrays)
+            {
+                for (size_t i = 0; i < chunk.count; ++i) f(entities[i], arrays[i]...);
+            };
+            run(ecs_chunk_entities(archetype, chunk), ecs_chunk_array<Ts>(archetype, chunk)...);
+        }
+    });
+}
@@ -0,0 +1,71 @@
+#include "effects.h"
+
+constexpr uint32_t SCORE_POPUP_TICKS = 45;
+constexpr uint32_t SCORE_POPUP_FADE_TICKS = 15;
+
+void effects_init(Effects* effects)
+{
+    ecs_init(&effects->world);
+    effects->expired.clear();
+    effects->fading.clear();
+}
+
+void effects_shutdown(Effects* effects)
+{
+    ecs_shutdown(&effects->world);
+}
+
+void effects_emit_events(Effects* effects, const GameEvents& events)
+{
+    for (size_t i = 0; i < events.num_events; ++i)
+    {
+        const auto& event = events.events[i];
+        // Divers that rammed the player are worth nothing
+        if (event.type != EVENT_ALIEN_KILLED || event.points == 0) continue;
+
+        ecs_create(&effects->world,
+            EffectPosition{ float(event.x), float(event.y) + 8.0f },
+            EffectVelocity{ 0.0f, 0.5f },
+            EffectLifetime{ SCORE_POPUP_TICKS },
+            ScorePopup{ event.points });
+    }
+}
+
+void effects_update(Effects* effects, JobSystem* jobs)
+{
+    auto& world = effects->world;
+
+    ecs_parallel_each<EffectPosition, EffectVelocity>(&world, jobs,
+        [](EcsEntity, EffectPosition& position, const EffectVelocity& velocity)
+        {
+            position.x += velocity.x;
+            position.y += velocity.y;
+        });
+
+    ecs_each<EffectLifetime>(&world, [&](EcsEntity entity, EffectLifetime& lifetime)
+    {
+        --lifetime.ticks;
+        if (lifetime.ticks == 0) effects->expired.push_back(entity);
+        else if (lifetime.ticks == SCORE_POPUP_FADE_TICKS) effects->fading.push_back(entity);
+    });
+
+    for (auto entity : effects->fading) ecs_add(&world, entity, EffectBlink{ 4 });
+    for (auto entity : effects->expired) ecs_destroy(&world, entity);
+    effects->fading.clear();
+    effects->expired.clear();
+}
+
+void effects_render(const Effects& effects, const GameAssets& assets, Buffer* buffer, uint64_t tick)
+{
+    constexpr auto color = rgb_to_uint32(255, 255, 255);
+
+    ecs_each<EffectPosition, ScorePopup>(effects.world,
+        [&](EcsEntity entity, const EffectPosition& position, const ScorePopup& popup)
+        {
+            auto blink = ecs_get<EffectBlink>(effects.world, entity);
+            if (blink && (tick / blink->period) % 2) return;
+
+            buffer_draw_number(buffer, assets.number_spritesheet, popup.points,
+                size_t(position.x), size_t(position.y), color);
+        });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets.h"
+#include "buffer.h"
+#include "ecs.h"
+#include "game.h"
+#include "jobs.h"
+
+// Cosmetic entities of the front end, e.g. the points floating up from a
+// killed alien, kept in an ECS world. Like the particles they live outside of
+// Game and never affect the simulation.
+
+struct EffectPosition
+{
+    float x;
+    float y;
+};
+
+struct EffectVelocity
+{
+    float x;
+    float y;
+};
+
+struct EffectLifetime
+{
+    uint32_t ticks;
+};
+
+// Blinks with the given period, added to effects about to expire
+struct EffectBlink
+{
+    uint32_t period;
+};
+
+struct ScorePopup
+{
+    uint32_t points;
+};
+
+struct Effects
+{
+    EcsWorld world;
+    // Entities to change once the systems are done iterating
+    std::vector<EcsEntity> expired;
+    std::vector<EcsEntity> fading;
+};
+
+void effects_init(Effects* effects);
+
+void effects_shutdown(Effects* effects);
+
+// Spawns a score popup for every killed alien
+void effects_emit_events(Effects* effects, const GameEvents& events);
+
+// Runs the movement and lifetime systems, the former on the job system
+void effects_update(Effects* effects, JobSystem* jobs);
+
+void effects_render(const Effects& effects, const GameAssets& assets, Buffer* buffer, uint64_t tick);
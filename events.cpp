@@ -0,0 +1,81 @@
+#include "events.h"
+
+#include <algorithm>
+#include <bit>
+
+void event_bus_init(EventBus* bus)
+{
+    bus->rings.clear();
+}
+
+size_t event_bus_subscribe(EventBus* bus, size_t capacity)
+{
+    auto ring = std::make_unique<EventRing>();
+    capacity = std::bit_ceil(std::max<size_t>(capacity, GAME_MAX_EVENTS));
+
+    ring->events = std::make_unique<GameEvent[]>(capacity);
+    ring->mask = capacity - 1;
+    ring->head.store(0, std::memory_order_relaxed);
+    ring->tail.store(0, std::memory_order_relaxed);
+    ring->cached_head = 0;
+    ring->dropped.store(0, std::memory_order_relaxed);
+
+    bus->rings.push_back(std::move(ring));
+    return bus->rings.size() - 1;
+}
+
+void event_bus_publish(EventBus* bus, const GameEvents& events)
+{
+    if (events.num_events == 0) return;
+
+    for (auto& ring : bus->rings)
+    {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        size_t capacity = ring->mask + 1;
+
+        // Only look at the consumer's position when the cached one says full
+        size_t free = capacity - (tail - ring->cached_head);
+        if (free < events.num_events)
+        {
+            ring->cached_head = ring->head.load(std::memory_order_acquire);
+            free = capacity - (tail - ring->cached_head);
+        }
+
+        size_t count = std::min(free, events.num_events);
+        for (size_t i = 0; i < count; ++i)
+        {
+            ring->events[(tail + i) & ring->mask] = events.events[i];
+        }
+
+        if (count < events.num_events)
+        {
+            ring->dropped.fetch_add(events.num_events - count, std::memory_order_relaxed);
+        }
+
+        // The events written above become visible to the consumer all at once
+        ring->tail.store(tail + count, std::memory_order_release);
+    }
+}
+
+size_t event_bus_poll(EventBus* bus, size_t subscriber, GameEvents* batch)
+{
+    auto& ring = *bus->rings[subscriber];
+    uint64_t head = ring.head.load(std::memory_order_relaxed);
+    uint64_t tail = ring.tail.load(std::memory_order_acquire);
+
+    size_t count = std::min<size_t>(tail - head, GAME_MAX_EVENTS);
+    for (size_t i = 0; i < count; ++i)
+    {
+        batch->events[i] = ring.events[(head + i) & ring.mask];
+    }
+    batch->num_events = count;
+
+    // Hands the slots back to the producer once they have been copied
+    ring.head.store(head + count, std::memory_order_release);
+    return count;
+}
+
+uint64_t event_bus_dropped(const EventBus& bus, size_t subscriber)
+{
+    return bus.rings[subscriber]->dropped.load(std::memory_order_relaxed);
+}
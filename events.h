@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "game.h"
+
+// Hands the events of every tick to any number of consumers, e.g. particles,
+// audio or achievements, without game_step() knowing about them.
+//
+// Each subscriber gets its own single producer, single consumer ring buffer.
+// The game thread appends a tick's events to every ring and publishes them with
+// one release store per ring, a subscriber drains its ring whenever it likes,
+// in a later phase of the frame or on a thread of its own. Neither side ever
+// locks or waits. A subscriber that falls behind loses the events that do not
+// fit into its ring, they are counted in dropped.
+
+struct alignas(64) EventRing
+{
+    std::unique_ptr<GameEvent[]> events;
+    // Capacity - 1, the capacity is a power of two
+    size_t mask;
+    // Read position, only written by the consumer
+    alignas(64) std::atomic<uint64_t> head;
+    // Write position, only written by the producer
+    alignas(64) std::atomic<uint64_t> tail;
+    // The producer's copy of head, refreshed only when the ring looks full
+    uint64_t cached_head;
+    std::atomic<uint64_t> dropped;
+};
+
+struct EventBus
+{
+    std::vector<std::unique_ptr<EventRing>> rings;
+};
+
+void event_bus_init(EventBus* bus);
+
+// Adds a subscriber whose ring holds at least capacity events and returns its
+// index. Subscribe everyone before the first event_bus_publish().
+size_t event_bus_subscribe(EventBus* bus, size_t capacity);
+
+// Appends the events of a tick to every subscriber's ring. Game thread only.
+void event_bus_publish(EventBus* bus, const GameEvents& events);
+
+// Moves up to GAME_MAX_EVENTS of the subscriber's pending events into batch
+// and returns their number. Only one thread may poll a subscriber.
+size_t event_bus_poll(EventBus* bus, size_t subscriber, GameEvents* batch);
+
+// Events lost so far because the subscriber's ring was full
+uint64_t event_bus_dropped(const EventBus& bus, size_t subscriber);
@@ -0,0 +1,1713 @@
+#include "game.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <print>
+
+#include "boxes.h"
+
+constexpr uint32_t GAME_SNAPSHOT_MAGIC = 0x534e5649; // "IVNS"
+constexpr uint32_t GAME_SNAPSHOT_VERSION = 12;
+
+// Ticks between two alien shots of the same kind
+static const size_t alien_shot_reload[3] = { 48, 64, 80 };
+constexpr int ALIEN_SHOT_DIR = -1;
+
+// The mystery ship is worth one of these at random
+static const size_t ufo_points[4] = { 50, 100, 150, 300 };
+
+// Column sequence of the original. The plunger shot cycles through the first 16
+// entries and the squiggly shot through the entries from 6 on.
+static const uint8_t alien_shot_columns[] = {
+    0, 6, 0, 0, 0, 3, 10, 0, 5, 2, 0, 0, 10, 8, 1, 7, 1, 10, 3, 6, 9
+};
+static const size_t alien_shot_column_range[3][2] = { { 0, 0 }, { 0, 16 }, { 6, 21 } };
+
+// Pixels per tick along the dive paths
+constexpr float DIVE_SPEED = 1.5f;
+// Divers whose positions are evaluated together
+constexpr size_t DIVE_BATCH = 64;
+
+// Rank of a bullet fired since the bullets were last sorted
+constexpr uint32_t BULLET_UNORDERED = UINT32_MAX;
+
+enum HashKind: uint64_t
+{
+    HASH_ALIEN = 1,
+    HASH_PLAYER,
+    HASH_BULLET,
+    HASH_SHIELD,
+    HASH_UFO
+};
+
+// Zobrist keys are derived by mixing the key's coordinates instead of being
+// looked up in tables, which would have to be as big as the playfield.
+static uint64_t hash_key(HashKind kind, uint64_t a, uint64_t b = 0)
+{
+    uint64_t z = (uint64_t(kind) << 58) ^ (a << 29) ^ b;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+static uint64_t hash_alien(size_t ai, const Alien& alien)
+{
+    return hash_key(HASH_ALIEN, ai, (uint64_t(alien.x) << 20) ^ alien.y);
+}
+
+static uint64_t hash_bullet(const Bullet& bullet)
+{
+    return hash_key(HASH_BULLET, bullet.x,
+        (bullet.y << 16) ^ (uint64_t(bullet.fresh) << 12) ^ (bullet.type << 8) ^ uint8_t(bullet.dir));
+}
+
+static uint64_t hash_player(const Player& player)
+{
+    return hash_key(HASH_PLAYER, player.x, player.life);
+}
+
+static uint64_t hash_ufo(const Ufo& ufo)
+{
+    return ufo.active ? hash_key(HASH_UFO, ufo.x, uint8_t(ufo.dir)) : 0;
+}
+
+static uint64_t hash_shield_row(size_t shield, size_t row, uint32_t bits)
+{
+    return hash_key(HASH_SHIELD, shield * SHIELD_HEIGHT + row, bits);
+}
+
+bool sprite_overlap_check(const Sprite& sp_a, size_t x_a, size_t y_a,
+    const Sprite& sp_b, size_t x_b, size_t y_b)
+{
+    return (x_a < (x_b + sp_b.width) && (x_a + sp_a.width) > x_b &&
+        y_a < (y_b + sp_b.height) && (y_a + sp_a.height) > y_b);
+}
+
+GameConfig game_default_config()
+{
+    GameConfig config;
+    config.width = 224;
+    config.height = 256;
+    config.columns = 11;
+    config.rows = 5;
+    config.max_bullets = 128;
+    config.bullet_speed = 1;
+    config.max_divers = 2;
+    config.dive_interval = 300;
+    config.pixel_collisions = false;
+    return config;
+}
+
+GameConfig game_stress_config()
+{
+    GameConfig config;
+    config.width = 4096;
+    config.height = 4096;
+    config.columns = 1000;
+    config.rows = 100;
+    config.max_bullets = 1 << 16;
+    config.bullet_speed = 1;
+    config.max_divers = 4096;
+    config.dive_interval = 1;
+    config.pixel_collisions = false;
+    return config;
+}
+
+bool game_config_parse_option(GameConfig* config, int argc, char** argv, int* i)
+{
+    bool has_value = *i + 1 < argc;
+
+    if (!std::strcmp(argv[*i], "--stress"))
+        *config = game_stress_config();
+    else if (!std::strcmp(argv[*i], "--pixel-collisions"))
+        config->pixel_collisions = true;
+    else if (!std::strcmp(argv[*i], "--width") && has_value)
+        config->width = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--height") && has_value)
+        config->height = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--columns") && has_value)
+        config->columns = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--rows") && has_value)
+        config->rows = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--bullets") && has_value)
+        config->max_bullets = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--bullet-speed") && has_value)
+        config->bullet_speed = std::strtoull(argv[++*i], nullptr, 10);
+    else if (!std::strcmp(argv[*i], "--divers") && has_value)
+        config->max_divers = std::strtoull(argv[++*i], nullptr, 10);
+    else
+        return false;
+
+    return true;
+}
+
+void game_config_finish(GameConfig* config)
+{
+    config->width = std::clamp<size_t>(config->width, 224, GAME_MAX_SIZE);
+    config->height = std::clamp<size_t>(config->height, 256, GAME_MAX_SIZE);
+
+    // Packed down to one pixel per alien, see game_init(), the formation spans
+    // as many pixels as it has columns and rows. Beyond that aliens would be
+    // off the playfield, out of reach of the player's shots.
+    config->columns = std::clamp<size_t>(config->columns, 1, config->width - 40);
+    config->rows = std::clamp<size_t>(config->rows, 1, config->height / 2 - 32);
+
+    config->max_bullets = std::clamp<size_t>(config->max_bullets, 1, GAME_MAX_OBJECTS);
+    config->bullet_speed = std::clamp<size_t>(config->bullet_speed, 1, 32);
+    config->max_divers = std::min(config->max_divers, GAME_MAX_OBJECTS);
+    config->dive_interval = std::max<size_t>(config->dive_interval, 1);
+}
+
+void game_config_print_usage()
+{
+    std::println("  --stress         {} x {} aliens on a {} x {} playfield",
+        game_stress_config().columns, game_stress_config().rows,
+        game_stress_config().width, game_stress_config().height);
+    std::println("  --width W        playfield width, 224 to {} (default: 224)", GAME_MAX_SIZE);
+    std::println("  --height H       playfield height, 256 to {} (default: 256)", GAME_MAX_SIZE);
+    std::println("  --columns C      columns of the alien formation, at most W - 40 (default: 11)");
+    std::println("  --rows R         rows of the alien formation, at most H / 2 - 32 (default: 5)");
+    std::println("  --bullets B      bullets on screen at once, up to {} (default: 128)", GAME_MAX_OBJECTS);
+    std::println("  --bullet-speed S bullets move S times as fast, up to 32 (default: 1)");
+    std::println("  --divers D       aliens diving at once, up to {}, 0 disables dives (default: 2)", GAME_MAX_OBJECTS);
+    std::println("  --pixel-collisions  hit aliens by their pixels rather than their boxes");
+}
+
+static void game_scratch_init(GameScratch* scratch, size_t num_aliens, size_t num_pixels)
+{
+    scratch->num_aliens = num_aliens;
+    box_set_clear(&scratch->alien_boxes);
+    box_set_reserve(&scratch->alien_boxes, num_aliens);
+    scratch->alien_box_masks = std::vector<uint64_t>(box_set_mask_words(num_aliens));
+    scratch->alien_ids = std::vector<uint32_t>(num_pixels);
+    scratch->ids_bottom = 0;
+    scratch->ids_top = 0;
+}
+
+GameScratch::GameScratch(const GameScratch& other)
+{
+    game_scratch_init(this, other.num_aliens, other.alien_ids.size());
+}
+
+// The contents are rebuilt by every step, so they are not copied
+GameScratch& GameScratch::operator=(const GameScratch& other)
+{
+    if (num_aliens != other.num_aliens || alien_ids.size() != other.alien_ids.size())
+    {
+        game_scratch_init(this, other.num_aliens, other.alien_ids.size());
+    }
+    return *this;
+}
+
+void game_init(Game* game, const GameAssets& assets, const GameConfig& config, uint64_t seed)
+{
+    game->width = config.width;
+    game->height = config.height;
+    game->num_aliens = config.columns * config.rows;
+    game->num_alive = game->num_aliens;
+    game->num_columns = config.columns;
+    game->max_bullets = config.max_bullets;
+    game->num_bullets = 0;
+    game->bullet_speed = config.bullet_speed;
+    game->max_divers = config.max_divers;
+    game->dive_interval = std::max<size_t>(config.dive_interval, 1);
+    game->num_divers = 0;
+    game->pixel_collisions = config.pixel_collisions;
+    game->score = 0;
+    game->tick = 0;
+    game->aliens = std::vector<Alien>(game->num_aliens);
+    game->death_counters = std::vector<uint8_t>(game->num_aliens, 10);
+    game->column_shooters = std::vector<size_t>(game->num_columns);
+    game->bullets = std::vector<Bullet>(game->max_bullets);
+    game->num_ordered = 0;
+    game->bullet_order = std::vector<uint32_t>(game->max_bullets);
+    game->bullet_ranks = std::vector<uint32_t>(game->max_bullets, BULLET_UNORDERED);
+    game->divers = std::vector<Diver>(game->max_divers);
+    game_scratch_init(&game->scratch, game->num_aliens,
+        config.pixel_collisions ? game->width * game->height : 0);
+    game->player.x = game->width / 2 - 5;
+    game->player.y = 32;
+    game->player.life = 3;
+    game->ufo.x = 0;
+    game->ufo.y = game->height - 40;
+    game->ufo.dir = 0;
+    game->ufo.active = false;
+
+    // Four bunkers spread evenly above the player
+    size_t shield_spacing = (game->width - 64 - assets.shield_sprite.width) / (GAME_NUM_SHIELDS - 1);
+    for (size_t si = 0; si < GAME_NUM_SHIELDS; ++si)
+    {
+        auto& shield = game->shields[si];
+        shield.x = 32 + shield_spacing * si;
+        shield.y = 48;
+        std::copy(assets.shield_packed.rows.begin(), assets.shield_packed.rows.end(), shield.rows);
+    }
+
+    for (size_t i = 0; i < 3; ++i)
+    {
+        game->alien_shots[i].reload = alien_shot_reload[i];
+        game->alien_shots[i].column_index = alien_shot_column_range[i][0];
+    }
+
+    // The formation fills the upper half of the playfield, larger ones are packed
+    // closer together until the aliens overlap
+    size_t spacing_x = std::clamp<size_t>((game->width - 40) / config.columns, 1, 16);
+    size_t spacing_y = std::clamp<size_t>((game->height / 2 - 32) / config.rows, 1, 17);
+
+    for (size_t yi = 0; yi < config.rows; ++yi)
+    {
+        // Like the original's 1, 2 and 2 rows of each type from the top down
+        size_t band = yi * 5 / config.rows;
+
+        for (size_t xi = 0; xi < config.columns; ++xi)
+        {
+            auto& alien = game->aliens[yi * config.columns + xi];
+            alien.type = static_cast<AlienType>((5 - band) / 2 + 1);
+            alien.diving = false;
+
+            auto& sprite = assets.alien_sprites[2 * (alien.type - 1)];
+            alien.x = spacing_x * xi + 20 + (assets.alien_death_sprite.width - sprite.width)/2;
+            alien.y = spacing_y * yi + game->height / 2;
+        }
+    }
+
+    for (size_t column = 0; column < game->num_columns; ++column)
+    {
+        game->column_shooters[column] = column;
+    }
+
+    game_seed(game, seed);
+    game->hash = game_compute_hash(*game);
+}
+
+void game_seed(Game* game, uint64_t seed)
+{
+    // xorshift must never be seeded with zero, mix the seed so nearby seeds
+    // give unrelated sequences (splitmix64 finalizer)
+    uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    z = z ^ (z >> 31);
+    game->rng_state = z ? z : 1;
+}
+
+uint32_t game_random(Game* game)
+{
+    uint64_t x = game->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    game->rng_state = x;
+    return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+const Sprite& game_bullet_sprite(const GameAssets& assets, const Bullet& bullet)
+{
+    if (bullet.type == BULLET_PLAYER) return assets.bullet_sprite;
+    return assets.alien_bullet_sprites[bullet.type - BULLET_ROLLING];
+}
+
+const Sprite& game_alien_sprite(const Game& game, const GameAssets& assets, AlienType type)
+{
+    return assets.alien_sprites[sprite_animation_frame(assets.alien_animation[type - 1], game.tick)];
+}
+
+uint64_t game_compute_hash(const Game& game)
+{
+    uint64_t hash = hash_player(game.player) ^ hash_ufo(game.ufo);
+
+    for (size_t ai = 0; ai < game.num_aliens; ++ai)
+    {
+        if (game.aliens[ai].type != ALIEN_DEAD) hash ^= hash_alien(ai, game.aliens[ai]);
+    }
+
+    for (size_t bi = 0; bi < game.num_bullets; ++bi)
+    {
+        hash ^= hash_bullet(game.bullets[bi]);
+    }
+
+    for (size_t si = 0; si < GAME_NUM_SHIELDS; ++si)
+    {
+        for (size_t row = 0; row < SHIELD_HEIGHT; ++row)
+        {
+            hash ^= hash_shield_row(si, row, game.shields[si].rows[row]);
+        }
+    }
+
+    return hash;
+}
+
+bool game_is_over(const Game& game)
+{
+    return game.player.life == 0 || game.num_alive == 0;
+}
+
+// Tests a box against the intact pixels of a shield. The box's columns become a
+// single row mask, which is then ANDed with each shield row the box spans.
+static bool shield_overlap(const Shield& shield, size_t shield_width,
+    size_t x, size_t y, size_t width, size_t height)
+{
+    if (x + width <= shield.x || x >= shield.x + shield_width ||
+        y + height <= shield.y || y >= shield.y + SHIELD_HEIGHT)
+    {
+        return false;
+    }
+
+    int64_t column = int64_t(x) - int64_t(shield.x);
+    uint64_t box = (uint64_t(1) << width) - 1;
+    uint32_t mask = column >= 0 ? uint32_t(box << column) : uint32_t(box >> -column);
+
+    // Row 0 is the top of the shield
+    size_t bottom = std::max(y, shield.y);
+    size_t top = std::min(y + height, shield.y + SHIELD_HEIGHT);
+    uint32_t overlap = 0;
+    for (size_t sy = bottom; sy < top; ++sy)
+    {
+        overlap |= shield.rows[SHIELD_HEIGHT - 1 - (sy - shield.y)];
+    }
+
+    return overlap & mask;
+}
+
+// Blows a hole centered at (x, y) into a shield, clearing the explosion's
+// pixels with one AND per row using the pre-shifted masks of the assets.
+static void shield_erode(Game* game, const GameAssets& assets, size_t si, size_t x, size_t y)
+{
+    auto& shield = game->shields[si];
+    const auto& explosion = assets.shield_explosion_sprite;
+
+    int64_t shift = int64_t(x) - int64_t(explosion.width / 2) - int64_t(shield.x) + int64_t(explosion.width);
+    int64_t num_shifts = assets.shield_sprite.width + explosion.width;
+    if (shift < 0 || shift >= num_shifts) return;
+
+    const uint64_t* masks = &assets.shield_erosion_masks[shift * explosion.height];
+    int64_t explosion_top = int64_t(y) + int64_t(explosion.height / 2);
+
+    for (size_t r = 0; r < explosion.height; ++r)
+    {
+        int64_t row = int64_t(shield.y + SHIELD_HEIGHT - 1) - (explosion_top - int64_t(r));
+        if (row < 0 || row >= int64_t(SHIELD_HEIGHT)) continue;
+
+        game->hash ^= hash_shield_row(si, row, shield.rows[row]);
+        shield.rows[row] &= ~uint32_t(masks[r] >> explosion.width);
+        game->hash ^= hash_shield_row(si, row, shield.rows[row]);
+    }
+}
+
+enum BulletHitTarget: uint8_t
+{
+    BULLET_HIT_NONE = 0,
+    BULLET_HIT_SHIELD,
+    BULLET_HIT_PLAYER,
+    BULLET_HIT_UFO,
+    BULLET_HIT_ALIEN
+};
+
+// The first thing a bullet runs into during a tick
+struct BulletHit
+{
+    BulletHitTarget target;
+    size_t index;
+    // Pixels the bullet moved before touching it
+    size_t travel;
+};
+
+// Returned by the sweeps below for a bullet that touches nothing
+constexpr size_t SWEEP_MISS = SIZE_MAX;
+
+static void bullet_hit_update(BulletHit* hit, BulletHitTarget target, size_t index, size_t travel)
+{
+    // Ties go to the target tested first
+    if (travel >= hit->travel) return;
+
+    hit->target = target;
+    hit->index = index;
+    hit->travel = travel;
+}
+
+// Sweeps the bullet's box along its move of |dir| pixels against a box. Returns
+// the distance after which they first overlap, or SWEEP_MISS if they do not
+// touch. The start position was tested on the previous tick, so it is skipped
+// unless the bullet was just fired.
+static size_t sweep_box(const Bullet& bullet, const Sprite& bullet_sprite,
+    size_t x, size_t y, size_t width, size_t height)
+{
+    if (bullet.x >= x + width || bullet.x + bullet_sprite.width <= x) return SWEEP_MISS;
+
+    // The moving box overlaps the other one while first < travel < last
+    int64_t first, last;
+    if (bullet.dir > 0)
+    {
+        first = int64_t(y) - int64_t(bullet.y + bullet_sprite.height);
+        last = int64_t(y + height) - int64_t(bullet.y);
+    }
+    else
+    {
+        first = int64_t(bullet.y) - int64_t(y + height);
+        last = int64_t(bullet.y + bullet_sprite.height) - int64_t(y);
+    }
+
+    int64_t travel = std::max<int64_t>(first + 1, bullet.fresh ? 0 : 1);
+    if (travel >= last || travel > std::abs(bullet.dir)) return SWEEP_MISS;
+    return travel;
+}
+
+// Like sweep_box(), but against the intact pixels of a shield, which are only
+// tested at the positions where the boxes overlap
+static size_t sweep_shield(const Shield& shield, size_t shield_width,
+    const Bullet& bullet, const Sprite& bullet_sprite)
+{
+    size_t travel = sweep_box(bullet, bullet_sprite, shield.x, shield.y, shield_width, SHIELD_HEIGHT);
+    if (travel == SWEEP_MISS) return SWEEP_MISS;
+
+    for (size_t t = travel; t <= size_t(std::abs(bullet.dir)); ++t)
+    {
+        size_t y = bullet.y + (bullet.dir > 0 ? t : -t);
+        if (shield_overlap(shield, shield_width, bullet.x, y, bullet_sprite.width, bullet_sprite.height))
+        {
+            return t;
+        }
+    }
+
+    return SWEEP_MISS;
+}
+
+// Boxes of all aliens, indexed like the aliens. Dead ones overlap nothing.
+static void game_alien_boxes(const Game& game, const GameAssets& assets, BoxSet* boxes)
+{
+    box_set_clear(boxes);
+
+    for (size_t ai = 0; ai < game.num_aliens; ++ai)
+    {
+        const auto& alien = game.aliens[ai];
+        if (alien.type == ALIEN_DEAD)
+        {
+            box_set_remove(boxes, box_set_add(boxes, 0, 0, 0, 0));
+            continue;
+        }
+
+        const auto& sprite = game_alien_sprite(game, assets, alien.type);
+        box_set_add(boxes, alien.x, alien.y, sprite.width, sprite.height);
+    }
+}
+
+// Writes id under the set pixels of a sprite into an id plane of the playfield
+static void ids_draw_sprite(const Game& game, uint32_t* ids, const Sprite& sprite,
+    size_t x, size_t y, uint32_t id)
+{
+    for (size_t yi = 0; yi < sprite.height; ++yi)
+    {
+        size_t sy = sprite.height - 1 + y - yi;
+        if (sy >= game.height) continue;
+
+        for (size_t xi = 0; xi < sprite.width; ++xi)
+        {
+            size_t sx = x + xi;
+            if (sprite.data[yi * sprite.width + xi] && sx < game.width) ids[sy * game.width + sx] = id;
+        }
+    }
+}
+
+// Draws the living aliens into the scratch id plane. Only the rows drawn last
+// time are cleared, the rest of the plane is still zero.
+static void game_alien_pixels(Game* game, const GameAssets& assets)
+{
+    auto& scratch = game->scratch;
+    uint32_t* ids = scratch.alien_ids.data();
+    std::fill(ids + scratch.ids_bottom * game->width, ids + scratch.ids_top * game->width, 0);
+
+    size_t bottom = game->height;
+    size_t top = 0;
+    for (size_t ai = 0; ai < game->num_aliens; ++ai)
+    {
+        const auto& alien = game->aliens[ai];
+        if (alien.type == ALIEN_DEAD) continue;
+
+        const auto& sprite = game_alien_sprite(*game, assets, alien.type);
+        auto type = static_cast<EntityClass>(ENTITY_ALIEN_A + (alien.type - ALIEN_TYPE_A));
+        ids_draw_sprite(*game, ids, sprite, alien.x, alien.y, game_entity_id(type, ai));
+
+        bottom = std::min(bottom, alien.y);
+        top = std::max(top, std::min(alien.y + sprite.height, game->height));
+    }
+
+    scratch.ids_bottom = std::min(bottom, top);
+    scratch.ids_top = top;
+}
+
+// Like sweep_box(), but reads the alien ids under the bullet's pixels at every
+// step of its move. Returns the distance and the index of the first alien it touches.
+static size_t sweep_pixels(const Game& game, const Bullet& bullet, const Sprite& bullet_sprite,
+    size_t* ai)
+{
+    const auto& sprite = bullet_sprite;
+    const uint32_t* ids = game.scratch.alien_ids.data();
+
+    for (size_t t = bullet.fresh ? 0 : 1; t <= size_t(std::abs(bullet.dir)); ++t)
+    {
+        size_t y = bullet.y + (bullet.dir > 0 ? t : -t);
+
+        for (size_t yi = 0; yi < sprite.height; ++yi)
+        {
+            size_t sy = sprite.height - 1 + y - yi;
+            if (sy >= game.height) continue;
+
+            for (size_t xi = 0; xi < sprite.width; ++xi)
+            {
+                size_t sx = bullet.x + xi;
+                if (!sprite.data[yi * sprite.width + xi] || sx >= game.width) continue;
+
+                if (uint32_t id = ids[sy * game.width + sx])
+                {
+                    *ai = game_entity_id_index(id);
+                    return t;
+                }
+            }
+        }
+    }
+
+    return SWEEP_MISS;
+}
+
+// Finds the lowest living alien of a column, starting the search at the row of
+// the alien with index from. Only called when the current shooter died, so the
+// table never needs a full scan of the aliens.
+static void game_update_shooter(Game* game, size_t column, size_t from)
+{
+    size_t ai = from;
+    while (ai < game->num_aliens && game->aliens[ai].type == ALIEN_DEAD)
+    {
+        ai += game->num_columns;
+    }
+
+    game->column_shooters[column] = std::min(ai, game->num_aliens);
+}
+
+// Whether the lowest alien of a column can fire. Divers have left the formation
+// and hold their column's fire until they are back.
+static bool alien_shooter_ready(const Game& game, size_t column)
+{
+    size_t ai = game.column_shooters[column];
+    return ai != game.num_aliens && !game.aliens[ai].diving;
+}
+
+// Picks the column of the next alien shot, or returns false if no alien is left
+// to fire it
+static bool alien_shot_column(Game* game, const GameAssets& assets, size_t shot, size_t* column)
+{
+    if (shot == 0)
+    {
+        // Aim at the player, using the shooter closest to the player's center
+        size_t target = game->player.x + assets.player_sprite.width / 2;
+        size_t best_distance = SIZE_MAX;
+        for (size_t c = 0; c < game->num_columns; ++c)
+        {
+            if (!alien_shooter_ready(*game, c)) continue;
+
+            size_t x = game->aliens[game->column_shooters[c]].x + assets.alien_death_sprite.width / 2;
+            size_t distance = x > target ? x - target : target - x;
+            if (distance < best_distance)
+            {
+                best_distance = distance;
+                *column = c;
+            }
+        }
+
+        return best_distance != SIZE_MAX;
+    }
+
+    auto& alien_shot = game->alien_shots[shot];
+    size_t begin = alien_shot_column_range[shot][0];
+    size_t end = alien_shot_column_range[shot][1];
+
+    // Walk the sequence until it hits a column with aliens left
+    for (size_t i = begin; i < end; ++i)
+    {
+        // Spread the sequence of the original 11 columns over the formation
+        size_t c = alien_shot_columns[alien_shot.column_index] * game->num_columns / 11;
+        if (++alien_shot.column_index == end) alien_shot.column_index = begin;
+
+        if (alien_shooter_ready(*game, c))
+        {
+            *column = c;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void game_event(GameEvents* events, GameEventType type, AlienType alien_type,
+    size_t x, size_t y, size_t value, size_t points = 0)
+{
+    if (!events || events->num_events == GAME_MAX_EVENTS) return;
+
+    auto& event = events->events[events->num_events++];
+    event.type = type;
+    event.alien_type = alien_type;
+    event.x = x;
+    event.y = y;
+    event.value = value;
+    event.points = points;
+}
+
+// Kills a living alien, worth the given points
+static void game_kill_alien(Game* game, const GameAssets& assets, size_t ai, size_t points,
+    GameEvents* events)
+{
+    auto& alien = game->aliens[ai];
+    const auto& alien_sprite = game_alien_sprite(*game, assets, alien.type);
+
+    game->score += points;
+    game->hash ^= hash_alien(ai, alien);
+    game_event(events, EVENT_ALIEN_KILLED, alien.type, alien.x, alien.y, ai, points);
+    if (points) game_event(events, EVENT_SCORE_CHANGED, alien.type, alien.x, alien.y, game->score);
+    alien.type = ALIEN_DEAD;
+    --game->num_alive;
+    size_t column = ai % game->num_columns;
+    if (game->column_shooters[column] == ai) game_update_shooter(game, column, ai);
+    // NOTE: Hack to recenter death sprite
+    alien.x -= std::min(alien.x, (assets.alien_death_sprite.width - alien_sprite.width) / 2);
+}
+
+// Sends a few random aliens of the formation diving
+static void game_launch_divers(Game* game, const GameAssets& assets)
+{
+    size_t launches = std::max<size_t>(game->max_divers / DIVE_BATCH, 1);
+    size_t num_paths = assets.dive_paths.lengths.size();
+
+    for (size_t i = 0; i < launches && game->num_divers < game->max_divers; ++i)
+    {
+        // Give up after a few tries when most aliens are dead or diving already
+        for (size_t attempt = 0; attempt < 4; ++attempt)
+        {
+            size_t ai = game_random(game) % game->num_aliens;
+            auto& alien = game->aliens[ai];
+            if (alien.type == ALIEN_DEAD || alien.diving) continue;
+
+            alien.diving = true;
+            auto& diver = game->divers[game->num_divers++];
+            diver.alien = ai;
+            diver.home_x = alien.x;
+            diver.home_y = alien.y;
+            diver.distance = 0;
+            diver.path = game_random(game) % num_paths;
+            break;
+        }
+    }
+}
+
+// Moves the divers along their paths. Finished dives are removed first, so the
+// positions of the remaining ones can be evaluated in batches.
+static void game_move_divers(Game* game, const GameAssets& assets, GameEvents* events)
+{
+    const auto& paths = assets.dive_paths;
+
+    for (size_t di = 0; di < game->num_divers;)
+    {
+        auto& diver = game->divers[di];
+        auto& alien = game->aliens[diver.alien];
+        diver.distance += DIVE_SPEED;
+
+        if (alien.type != ALIEN_DEAD && diver.distance < paths.lengths[diver.path])
+        {
+            ++di;
+            continue;
+        }
+
+        // Back in the formation, or shot down
+        if (alien.type != ALIEN_DEAD)
+        {
+            game->hash ^= hash_alien(diver.alien, alien);
+            alien.x = diver.home_x;
+            alien.y = diver.home_y;
+            game->hash ^= hash_alien(diver.alien, alien);
+        }
+        alien.diving = false;
+        diver = game->divers[--game->num_divers];
+    }
+
+    const auto& player_sprite = assets.player_sprite;
+    uint16_t batch_paths[DIVE_BATCH];
+    float batch_distances[DIVE_BATCH];
+    float batch_x[DIVE_BATCH];
+    float batch_y[DIVE_BATCH];
+
+    for (size_t begin = 0; begin < game->num_divers; begin += DIVE_BATCH)
+    {
+        size_t count = std::min(DIVE_BATCH, game->num_divers - begin);
+        for (size_t i = 0; i < count; ++i)
+        {
+            batch_paths[i] = game->divers[begin + i].path;
+            batch_distances[i] = game->divers[begin + i].distance;
+        }
+
+        spline_evaluate(paths, batch_paths, batch_distances, batch_x, batch_y, count);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto& diver = game->divers[begin + i];
+            auto& alien = game->aliens[diver.alien];
+            if (alien.type == ALIEN_DEAD) continue;
+
+            const auto& alien_sprite = game_alien_sprite(*game, assets, alien.type);
+            int64_t max_x = int64_t(game->width - alien_sprite.width);
+            int64_t max_y = int64_t(game->height - alien_sprite.height);
+
+            game->hash ^= hash_alien(diver.alien, alien);
+            alien.x = std::clamp<int64_t>(int64_t(diver.home_x) + int64_t(batch_x[i]), 0, max_x);
+            alien.y = std::clamp<int64_t>(int64_t(diver.home_y) + int64_t(batch_y[i]), 0, max_y);
+            game->hash ^= hash_alien(diver.alien, alien);
+
+            // Ramming the player costs a life and the alien, without points
+            if (game->player.life > 0 && sprite_overlap_check(alien_sprite, alien.x, alien.y,
+                player_sprite, game->player.x, game->player.y))
+            {
+                game->hash ^= hash_player(game->player);
+                --game->player.life;
+                game->hash ^= hash_player(game->player);
+                game_event(events, EVENT_LIFE_LOST, ALIEN_DEAD,
+                    game->player.x, game->player.y, game->player.life);
+                game_kill_alien(game, assets, diver.alien, 0, events);
+            }
+        }
+    }
+}
+
+// Bullets of the same type move in lockstep, so their order never changes. Ties
+// are identical bullets, which can be swapped without changing anything.
+static bool bullet_order_less(const Game& game, uint32_t a, uint32_t b)
+{
+    const auto& bullet_a = game.bullets[a];
+    const auto& bullet_b = game.bullets[b];
+    if (bullet_a.x != bullet_b.x) return bullet_a.x < bullet_b.x;
+    if (bullet_a.type != bullet_b.type) return bullet_a.type < bullet_b.type;
+    return bullet_a.y < bullet_b.y;
+}
+
+// Removes a bullet by moving the last one into its slot. The moved bullet keeps
+// its place in bullet_order, so the order stays sorted.
+static void game_remove_bullet(Game* game, size_t bi)
+{
+    auto& ranks = game->bullet_ranks;
+    size_t last = --game->num_bullets;
+
+    if (ranks[bi] != BULLET_UNORDERED) game->bullet_order[ranks[bi]] = BULLET_UNORDERED;
+    if (bi == last) return;
+
+    game->bullets[bi] = game->bullets[last];
+    ranks[bi] = ranks[last];
+    if (ranks[bi] != BULLET_UNORDERED) game->bullet_order[ranks[bi]] = bi;
+}
+
+// Brings bullet_order up to date with the bullets. Bullets never move sideways,
+// so only the ones fired since the last call are out of place, and insertion
+// sort puts them there in close to linear time.
+static void game_sort_bullets(Game* game)
+{
+    auto& order = game->bullet_order;
+    auto& ranks = game->bullet_ranks;
+
+    size_t num_ordered = 0;
+    for (size_t i = 0; i < game->num_ordered; ++i)
+    {
+        if (order[i] != BULLET_UNORDERED) order[num_ordered++] = order[i];
+    }
+
+    size_t num_sorted = num_ordered;
+    for (size_t bi = 0; bi < game->num_bullets; ++bi)
+    {
+        if (ranks[bi] == BULLET_UNORDERED) order[num_ordered++] = bi;
+    }
+    game->num_ordered = num_ordered;
+
+    auto less = [game](uint32_t a, uint32_t b) { return bullet_order_less(*game, a, b); };
+
+    // Starting from scratch, e.g. after a restore
+    if (num_ordered - num_sorted > 64)
+    {
+        std::sort(order.begin(), order.begin() + num_ordered, less);
+    }
+    else
+    {
+        for (size_t i = num_sorted; i < num_ordered; ++i)
+        {
+            uint32_t bi = order[i];
+            size_t j = i;
+            for (; j > 0 && less(bi, order[j - 1]); --j)
+            {
+                order[j] = order[j - 1];
+            }
+            order[j] = bi;
+        }
+    }
+
+    for (size_t i = 0; i < num_ordered; ++i)
+    {
+        ranks[order[i]] = i;
+    }
+}
+
+// Rows a bullet covered during its last move, [*bottom, *top)
+static void bullet_swept_rows(const Bullet& bullet, const Sprite& sprite, size_t* bottom, size_t* top)
+{
+    size_t previous_y = bullet.y - bullet.dir;
+    *bottom = std::min(bullet.y, previous_y);
+    *top = std::max(bullet.y, previous_y) + sprite.height;
+}
+
+// The player's and the aliens' shots destroy each other when they meet. Sort
+// and sweep along x, only bullets whose columns overlap are compared. Shots
+// move towards each other, so if the rows they swept overlap they have met.
+static void game_collide_bullets(Game* game, const GameAssets& assets, GameEvents* events)
+{
+    game_sort_bullets(game);
+
+    const auto& order = game->bullet_order;
+    bool collided = false;
+
+    for (size_t i = 0; i < game->num_ordered; ++i)
+    {
+        auto& a = game->bullets[order[i]];
+        if (a.dir == 0) continue;
+
+        const auto& a_sprite = game_bullet_sprite(assets, a);
+        size_t a_bottom, a_top;
+        bullet_swept_rows(a, a_sprite, &a_bottom, &a_top);
+
+        for (size_t j = i + 1; j < game->num_ordered; ++j)
+        {
+            auto& b = game->bullets[order[j]];
+            if (b.x >= a.x + a_sprite.width) break;
+            if (b.dir == 0 || (a.type == BULLET_PLAYER) == (b.type == BULLET_PLAYER)) continue;
+
+            const auto& b_sprite = game_bullet_sprite(assets, b);
+            size_t b_bottom, b_top;
+            bullet_swept_rows(b, b_sprite, &b_bottom, &b_top);
+            if (a_bottom >= b_top || b_bottom >= a_top) continue;
+
+            const auto& shot = a.type == BULLET_PLAYER ? a : b;
+            game_event(events, EVENT_SHOTS_COLLIDED, ALIEN_DEAD, shot.x, shot.y, 0);
+
+            // Marks both for removal below, no moving bullet has a direction of 0
+            game->hash ^= hash_bullet(a) ^ hash_bullet(b);
+            a.dir = 0;
+            b.dir = 0;
+            collided = true;
+            break;
+        }
+    }
+
+    if (!collided) return;
+
+    // From the back, so the bullet moved into a slot is never a marked one
+    for (size_t bi = game->num_bullets; bi-- > 0;)
+    {
+        if (game->bullets[bi].dir == 0) game_remove_bullet(game, bi);
+    }
+}
+
+void game_ufo_spawn(Game* game, const GameAssets& assets, int dir)
+{
+    if (game->ufo.active) return;
+
+    game->ufo.dir = dir > 0 ? 1 : -1;
+    game->ufo.x = dir > 0 ? 0 : game->width - assets.ufo_sprite.width;
+    game->ufo.active = true;
+    game->hash ^= hash_ufo(game->ufo);
+}
+
+bool game_ufo_move(Game* game, const GameAssets& assets)
+{
+    if (!game->ufo.active) return false;
+
+    game->hash ^= hash_ufo(game->ufo);
+
+    // Leaving the screen on the left wraps around and fails the check too
+    game->ufo.x += game->ufo.dir;
+    if (game->ufo.x + assets.ufo_sprite.width > game->width)
+    {
+        game->ufo.active = false;
+        return false;
+    }
+
+    game->hash ^= hash_ufo(game->ufo);
+    return true;
+}
+
+void game_step(Game* game, const GameAssets& assets, const GameInput& input,
+    GameEvents* events)
+{
+    if (events) events->num_events = 0;
+    ++game->tick;
+
+    const auto& player_sprite = assets.player_sprite;
+
+    // Simulate aliens
+    for (size_t ai = 0; ai < game->num_aliens; ++ai)
+    {
+        const auto& alien = game->aliens[ai];
+        if (alien.type == ALIEN_DEAD && game->death_counters[ai])
+        {
+            --game->death_counters[ai];
+        }
+    }
+
+    // Simulate divers
+    if (game->max_divers > 0 && game->tick % game->dive_interval == 0)
+    {
+        game_launch_divers(game, assets);
+    }
+    game_move_divers(game, assets, events);
+
+    // Simulate bullets. Each bullet is swept along its whole move and hits the
+    // first thing in its way, so fast bullets cannot skip over an alien. The
+    // aliens' boxes, or pixels, are gathered once the first player's shot needs them.
+    auto& alien_boxes = game->scratch.alien_boxes;
+    auto& alien_box_masks = game->scratch.alien_box_masks;
+    bool alien_boxes_ready = false;
+    bool alien_pixels_ready = false;
+
+    for (size_t bi = 0; bi < game->num_bullets;)
+    {
+        const auto bullet = game->bullets[bi];
+        const auto& bullet_sprite = game_bullet_sprite(assets, bullet);
+        game->hash ^= hash_bullet(bullet);
+
+        BulletHit hit = { BULLET_HIT_NONE, 0, SIZE_MAX };
+        for (size_t si = 0; si < GAME_NUM_SHIELDS; ++si)
+        {
+            size_t travel = sweep_shield(game->shields[si], assets.shield_sprite.width,
+                bullet, bullet_sprite);
+            bullet_hit_update(&hit, BULLET_HIT_SHIELD, si, travel);
+        }
+
+        // Alien shots only hit the player, the player's shots only hit aliens
+        if (bullet.type != BULLET_PLAYER)
+        {
+            if (game->player.life > 0)
+            {
+                size_t travel = sweep_box(bullet, bullet_sprite,
+                    game->player.x, game->player.y, player_sprite.width, player_sprite.height);
+                bullet_hit_update(&hit, BULLET_HIT_PLAYER, 0, travel);
+            }
+        }
+        else
+        {
+            if (game->ufo.active)
+            {
+                size_t travel = sweep_box(bullet, bullet_sprite,
+                    game->ufo.x, game->ufo.y, assets.ufo_sprite.width, assets.ufo_sprite.height);
+                bullet_hit_update(&hit, BULLET_HIT_UFO, 0, travel);
+            }
+
+            if (game->pixel_collisions)
+            {
+                if (!alien_pixels_ready)
+                {
+                    game_alien_pixels(game, assets);
+                    alien_pixels_ready = true;
+                }
+
+                size_t ai = 0;
+                size_t travel = sweep_pixels(*game, bullet, bullet_sprite, &ai);
+                bullet_hit_update(&hit, BULLET_HIT_ALIEN, ai, travel);
+            }
+            else
+            {
+                if (!alien_boxes_ready)
+                {
+                    game_alien_boxes(*game, assets, &alien_boxes);
+                    alien_boxes_ready = true;
+                }
+
+                // Test the box swept by the whole move against all aliens at
+                // once, then find out when the bullet reaches the few it overlaps
+                int32_t skipped = bullet.fresh ? 0 : 1;
+                int32_t sweep_y = bullet.y + skipped;
+                int32_t sweep_height = bullet_sprite.height + bullet.dir - skipped;
+                box_set_overlaps(alien_boxes, bullet.x, sweep_y, bullet_sprite.width, sweep_height,
+                    alien_box_masks.data());
+
+                for (size_t w = 0; w < alien_box_masks.size(); ++w)
+                {
+                    for (uint64_t bits = alien_box_masks[w]; bits; bits &= bits - 1)
+                    {
+                        size_t ai = 64 * w + std::countr_zero(bits);
+                        const auto& alien = game->aliens[ai];
+                        const auto& alien_sprite = game_alien_sprite(*game, assets, alien.type);
+                        size_t travel = sweep_box(bullet, bullet_sprite,
+                            alien.x, alien.y, alien_sprite.width, alien_sprite.height);
+                        bullet_hit_update(&hit, BULLET_HIT_ALIEN, ai, travel);
+                    }
+                }
+            }
+        }
+
+        if (hit.target == BULLET_HIT_NONE)
+        {
+            auto& moved = game->bullets[bi];
+            moved.y += moved.dir;
+            moved.fresh = false;
+
+            if (moved.y >= game->height || moved.y < bullet_sprite.height)
+            {
+                game_remove_bullet(game, bi);
+                continue;
+            }
+
+            game->hash ^= hash_bullet(moved);
+            ++bi;
+            continue;
+        }
+
+        switch (hit.target)
+        {
+        case BULLET_HIT_SHIELD:
+        {
+            size_t hit_y = bullet.y + (bullet.dir > 0 ? hit.travel : -hit.travel);
+            size_t impact_y = bullet.dir > 0 ? hit_y + bullet_sprite.height - 1 : hit_y;
+            shield_erode(game, assets, hit.index, bullet.x, impact_y);
+            break;
+        }
+        case BULLET_HIT_PLAYER:
+            game->hash ^= hash_player(game->player);
+            --game->player.life;
+            game->hash ^= hash_player(game->player);
+            game_event(events, EVENT_LIFE_LOST, ALIEN_DEAD,
+                game->player.x, game->player.y, game->player.life);
+            break;
+        case BULLET_HIT_UFO:
+        {
+            size_t points = ufo_points[game_random(game) % 4];
+            game->score += points;
+            game->hash ^= hash_ufo(game->ufo);
+            game->ufo.active = false;
+            game_event(events, EVENT_UFO_KILLED, ALIEN_DEAD, game->ufo.x, game->ufo.y, points, points);
+            game_event(events, EVENT_SCORE_CHANGED, ALIEN_DEAD, game->ufo.x, game->ufo.y, game->score);
+            break;
+        }
+        case BULLET_HIT_ALIEN:
+        {
+            const auto& alien = game->aliens[hit.index];
+            if (alien_boxes_ready) box_set_remove(&alien_boxes, hit.index);
+            if (alien_pixels_ready)
+            {
+                ids_draw_sprite(*game, game->scratch.alien_ids.data(),
+                    game_alien_sprite(*game, assets, alien.type), alien.x, alien.y, 0);
+            }
+
+            game_kill_alien(game, assets, hit.index, 10 * (AlienType::N - alien.type), events);
+            break;
+        }
+        default:
+            break;
+        }
+
+        // The last bullet was swapped into this slot, it still has to be simulated
+        game_remove_bullet(game, bi);
+    }
+
+    game_collide_bullets(game, assets, events);
+
+    // Simulate player
+    if (int player_move_dir = 2 * input.move_dir;
+        player_move_dir != 0)
+    {
+        game->hash ^= hash_player(game->player);
+
+        if (game->player.x + player_sprite.width + player_move_dir >= game->width)
+        {
+            game->player.x = game->width - player_sprite.width;
+        }
+        else if ((int) game->player.x + player_move_dir <= 0)
+        {
+            game->player.x = 0;
+        }
+        else
+        {
+            game->player.x += player_move_dir;
+        }
+
+        game->hash ^= hash_player(game->player);
+    }
+
+    // Player's fire
+    if (input.fire && game->num_bullets < game->max_bullets)
+    {
+        game->bullets[game->num_bullets].x = game->player.x + player_sprite.width / 2;
+        game->bullets[game->num_bullets].y = game->player.y + player_sprite.height;
+        game->bullets[game->num_bullets].dir = 2 * game->bullet_speed;
+        game->bullets[game->num_bullets].type = BULLET_PLAYER;
+        game->bullets[game->num_bullets].fresh = true;
+        game->bullet_ranks[game->num_bullets] = BULLET_UNORDERED;
+        game->hash ^= hash_bullet(game->bullets[game->num_bullets]);
+        game_event(events, EVENT_SHOT_FIRED, ALIEN_DEAD,
+            game->bullets[game->num_bullets].x, game->bullets[game->num_bullets].y, 0);
+        ++game->num_bullets;
+    }
+
+    // Aliens' fire, each kind of shot comes from the lowest alien of a column
+    for (size_t shot = 0; shot < 3; ++shot)
+    {
+        auto& alien_shot = game->alien_shots[shot];
+        if (alien_shot.reload > 0)
+        {
+            --alien_shot.reload;
+            continue;
+        }
+
+        size_t column;
+        if (game->num_bullets == game->max_bullets || !alien_shot_column(game, assets, shot, &column))
+        {
+            continue;
+        }
+
+        const auto& alien = game->aliens[game->column_shooters[column]];
+        const auto& alien_sprite = game_alien_sprite(*game, assets, alien.type);
+
+        // The shot starts below the alien, which needs room for it
+        if (alien.y < assets.alien_bullet_sprites[shot].height) continue;
+
+        auto& bullet = game->bullets[game->num_bullets++];
+        bullet.type = static_cast<BulletType>(BULLET_ROLLING + shot);
+        bullet.x = alien.x + alien_sprite.width / 2 - 1;
+        bullet.y = alien.y - assets.alien_bullet_sprites[shot].height;
+        bullet.dir = ALIEN_SHOT_DIR * int(game->bullet_speed);
+        bullet.fresh = true;
+        game->bullet_ranks[game->num_bullets - 1] = BULLET_UNORDERED;
+        game->hash ^= hash_bullet(bullet);
+        game_event(events, EVENT_ALIEN_SHOT_FIRED, alien.type, bullet.x, bullet.y, bullet.type);
+
+        alien_shot.reload = alien_shot_reload[shot];
+    }
+}
+
+void game_render(const Game& game, const GameAssets& assets, Buffer* buffer)
+{
+    constexpr auto clear_color = rgb_to_uint32(0, 0, 0);
+    constexpr auto color = rgb_to_uint32(128, 0, 0);
+    const auto& text_spritesheet = assets.text_spritesheet;
+    const auto& number_spritesheet = assets.number_spritesheet;
+
+    buffer_clear(buffer, clear_color);
+
+    buffer_draw_text(buffer, text_spritesheet, "SCORE", 4,
+        game.height - text_spritesheet.height - 7, color);
+
+    buffer_draw_number(buffer, number_spritesheet, game.score,
+        4 + 2 * number_spritesheet.width,
+        game.height - 2 * number_spritesheet.height - 12, color);
+
+    // Credits and a horizontal line above the credit text
+    buffer_draw_text(buffer, text_spritesheet, "CREDIT 00", game.width - 60, 7, color);
+
+    for (size_t i = 0; i < game.width; ++i)
+    {
+        buffer->data[game.width * 16 + i] = color;
+    }
+
+    for (size_t ai = 0; ai < game.num_aliens; ++ai)
+    {
+        /* If an alien is dead, we decrement the death counter,
+        and "remove" the alien from the game when the counter reaches 0.
+        When drawing the aliens, we now need to check if the death counter
+        is bigger than 0, otherwise we don't have to draw the alien.
+        This way, the death sprite is shown for 10 frames.*/
+        if (!game.death_counters[ai]) continue;
+
+        const auto& alien = game.aliens[ai];
+
+        if (alien.type == ALIEN_DEAD)
+        {
+            buffer_draw_sprite(buffer, assets.alien_death_sprite, alien.x, alien.y, color,
+                game_entity_id(ENTITY_ALIEN_DYING, ai));
+        }
+        else
+        {
+            const auto& sprite = game_alien_sprite(game, assets, alien.type);
+            auto type = static_cast<EntityClass>(ENTITY_ALIEN_A + (alien.type - ALIEN_TYPE_A));
+            buffer_draw_sprite(buffer, sprite, alien.x, alien.y, color, game_entity_id(type, ai));
+        }
+    }
+
+    for (size_t bi = 0; bi < game.num_bullets; ++bi)
+    {
+        const auto& bullet = game.bullets[bi];
+        buffer_draw_sprite(buffer, game_bullet_sprite(assets, bullet), bullet.x, bullet.y, color,
+            game_entity_id(ENTITY_BULLET, bi));
+    }
+
+    for (size_t si = 0; si < GAME_NUM_SHIELDS; ++si)
+    {
+        const auto& shield = game.shields[si];
+        buffer_draw_packed(buffer, shield.rows, assets.shield_sprite.width, SHIELD_HEIGHT,
+            shield.x, shield.y, color, game_entity_id(ENTITY_SHIELD, si));
+    }
+
+    if (game.ufo.active)
+    {
+        buffer_draw_sprite(buffer, assets.ufo_sprite, game.ufo.x, game.ufo.y, color,
+            game_entity_id(ENTITY_UFO, 0));
+    }
+
+    buffer_draw_sprite(buffer, assets.player_sprite, game.player.x, game.player.y, color,
+        game_entity_id(ENTITY_PLAYER, 0));
+}
+
+static bool entity_box(const Game& game, const Sprite& sprite, size_t x, size_t y,
+    EntityClass type, EntityBox* box)
+{
+    if (x >= game.width || y >= game.height) return false;
+
+    box->x = x;
+    box->y = y;
+    box->width = std::min(sprite.width, game.width - x);
+    box->height = std::min(sprite.height, game.height - y);
+    box->type = type;
+    return true;
+}
+
+size_t game_entity_boxes(const Game& game, const GameAssets& assets,
+    EntityBox* boxes, size_t max_boxes)
+{
+    size_t num_boxes = 0;
+
+    for (size_t ai = 0; ai < game.num_aliens && num_boxes < max_boxes; ++ai)
+    {
+        if (!game.death_counters[ai]) continue;
+
+        const auto& alien = game.aliens[ai];
+        if (alien.type == ALIEN_DEAD)
+        {
+            num_boxes += entity_box(game, assets.alien_death_sprite, alien.x, alien.y,
+                ENTITY_ALIEN_DYING, &boxes[num_boxes]);
+        }
+        else
+        {
+            const auto& sprite = game_alien_sprite(game, assets, alien.type);
+            auto type = static_cast<EntityClass>(ENTITY_ALIEN_A + (alien.type - ALIEN_TYPE_A));
+            num_boxes += entity_box(game, sprite, alien.x, alien.y, type, &boxes[num_boxes]);
+        }
+    }
+
+    for (size_t bi = 0; bi < game.num_bullets && num_boxes < max_boxes; ++bi)
+    {
+        const auto& bullet = game.bullets[bi];
+        num_boxes += entity_box(game, game_bullet_sprite(assets, bullet), bullet.x, bullet.y,
+            ENTITY_BULLET, &boxes[num_boxes]);
+    }
+
+    for (size_t si = 0; si < GAME_NUM_SHIELDS && num_boxes < max_boxes; ++si)
+    {
+        num_boxes += entity_box(game, assets.shield_sprite, game.shields[si].x, game.shields[si].y,
+            ENTITY_SHIELD, &boxes[num_boxes]);
+    }
+
+    if (game.ufo.active && num_boxes < max_boxes)
+    {
+        num_boxes += entity_box(game, assets.ufo_sprite, game.ufo.x, game.ufo.y,
+            ENTITY_UFO, &boxes[num_boxes]);
+    }
+
+    if (num_boxes < max_boxes)
+    {
+        num_boxes += entity_box(game, assets.player_sprite, game.player.x, game.player.y,
+            ENTITY_PLAYER, &boxes[num_boxes]);
+    }
+
+    return num_boxes;
+}
+
+size_t game_observation_size(const Game& game)
+{
+    size_t size = GAME_OBS_ALIVE + (game.num_aliens + 31) / 32;
+    return (size + 15) / 16 * 16;
+}
+
+void game_observe(const Game& game, uint32_t* observation)
+{
+    std::fill(observation, observation + game_observation_size(game), 0);
+
+    observation[GAME_OBS_PLAYER_X] = uint32_t(game.player.x);
+
+    size_t formation_x = SIZE_MAX;
+    size_t formation_y = SIZE_MAX;
+    uint32_t* alive = observation + GAME_OBS_ALIVE;
+    for (size_t ai = 0; ai < game.num_aliens; ++ai)
+    {
+        const auto& alien = game.aliens[ai];
+        if (alien.type == ALIEN_DEAD) continue;
+
+        alive[ai / 32] |= uint32_t(1) << (ai % 32);
+        if (alien.diving) continue;
+
+        formation_x = std::min(formation_x, alien.x);
+        formation_y = std::min(formation_y, alien.y);
+    }
+
+    if (formation_x != SIZE_MAX)
+    {
+        observation[GAME_OBS_FORMATION_X] = uint32_t(formation_x);
+        observation[GAME_OBS_FORMATION_Y] = uint32_t(formation_y);
+    }
+
+    // Insertion into a short sorted list, most bullets are rejected by the
+    // first compare once it is full
+    uint32_t* bullets = observation + GAME_OBS_BULLETS;
+    size_t num_bullets = 0;
+    for (size_t bi = 0; bi < game.num_bullets; ++bi)
+    {
+        const auto& bullet = game.bullets[bi];
+        uint32_t y = uint32_t(bullet.y);
+        if (num_bullets == GAME_OBS_MAX_BULLETS && y >= bullets[3 * (num_bullets - 1) + 1]) continue;
+
+        size_t i = std::min(num_bullets, GAME_OBS_MAX_BULLETS - 1);
+        for (; i > 0 && bullets[3 * (i - 1) + 1] > y; --i)
+        {
+            bullets[3 * i] = bullets[3 * (i - 1)];
+            bullets[3 * i + 1] = bullets[3 * (i - 1) + 1];
+            bullets[3 * i + 2] = bullets[3 * (i - 1) + 2];
+        }
+
+        bullets[3 * i] = uint32_t(bullet.x);
+        bullets[3 * i + 1] = y;
+        bullets[3 * i + 2] = bullet.type;
+        num_bullets = std::min(num_bullets + 1, GAME_OBS_MAX_BULLETS);
+    }
+    observation[GAME_OBS_NUM_BULLETS] = uint32_t(num_bullets);
+}
+
+template <typename T>
+static void snapshot_write(uint8_t*& dst, const T* value, size_t count = 1)
+{
+    std::memcpy(dst, value, sizeof(T) * count);
+    dst += sizeof(T) * count;
+}
+
+template <typename T>
+static void snapshot_read(const uint8_t*& src, T* value, size_t count = 1)
+{
+    std::memcpy(value, src, sizeof(T) * count);
+    src += sizeof(T) * count;
+}
+
+// Bools are read through a byte, anything but 0 or 1 is corrupt
+static bool snapshot_read_bool(const uint8_t*& src, bool* value)
+{
+    uint8_t byte;
+    snapshot_read(src, &byte);
+    *value = byte != 0;
+    return byte <= 1;
+}
+
+// The structs are written field by field, so no padding ends up in a snapshot
+// and equal states give equal snapshots. Reading one returns false if a field
+// is out of range for the game restored into.
+constexpr size_t SNAPSHOT_PLAYER_SIZE = 3 * sizeof(size_t);
+constexpr size_t SNAPSHOT_UFO_SIZE = 2 * sizeof(size_t) + sizeof(int) + sizeof(bool);
+constexpr size_t SNAPSHOT_ALIEN_SHOT_SIZE = 2 * sizeof(size_t);
+constexpr size_t SNAPSHOT_SHIELD_SIZE = 2 * sizeof(size_t) + SHIELD_HEIGHT * sizeof(uint32_t);
+constexpr size_t SNAPSHOT_BULLET_SIZE = 2 * sizeof(size_t) + sizeof(int) + sizeof(BulletType) + sizeof(bool);
+constexpr size_t SNAPSHOT_DIVER_SIZE = 3 * sizeof(size_t) + sizeof(float) + sizeof(uint16_t);
+constexpr size_t SNAPSHOT_ALIEN_SIZE = 2 * sizeof(size_t) + sizeof(AlienType) + sizeof(bool);
+
+static void snapshot_write_player(uint8_t*& dst, const Player& player)
+{
+    snapshot_write(dst, &player.x);
+    snapshot_write(dst, &player.y);
+    snapshot_write(dst, &player.life);
+}
+
+static bool snapshot_read_player(const uint8_t*& src, const Game& game, Player* player)
+{
+    snapshot_read(src, &player->x);
+    snapshot_read(src, &player->y);
+    snapshot_read(src, &player->life);
+    return player->x < game.width && player->y < game.height;
+}
+
+static void snapshot_write_ufo(uint8_t*& dst, const Ufo& ufo)
+{
+    snapshot_write(dst, &ufo.x);
+    snapshot_write(dst, &ufo.y);
+    snapshot_write(dst, &ufo.dir);
+    snapshot_write(dst, &ufo.active);
+}
+
+static bool snapshot_read_ufo(const uint8_t*& src, const Game& game, Ufo* ufo)
+{
+    snapshot_read(src, &ufo->x);
+    snapshot_read(src, &ufo->y);
+    snapshot_read(src, &ufo->dir);
+    bool valid = snapshot_read_bool(src, &ufo->active);
+    return valid && ufo->x < game.width && ufo->y < game.height && std::abs(ufo->dir) <= 1;
+}
+
+static void snapshot_write_alien_shot(uint8_t*& dst, const AlienShot& shot)
+{
+    snapshot_write(dst, &shot.reload);
+    snapshot_write(dst, &shot.column_index);
+}
+
+static bool snapshot_read_alien_shot(const uint8_t*& src, size_t shot_type, AlienShot* shot)
+{
+    snapshot_read(src, &shot->reload);
+    snapshot_read(src, &shot->column_index);
+
+    // The rolling shot has an empty sequence and keeps its index at 0
+    size_t begin = alien_shot_column_range[shot_type][0];
+    size_t end = std::max(alien_shot_column_range[shot_type][1], begin + 1);
+    return shot->column_index >= begin && shot->column_index < end;
+}
+
+static void snapshot_write_shield(uint8_t*& dst, const Shield& shield)
+{
+    snapshot_write(dst, &shield.x);
+    snapshot_write(dst, &shield.y);
+    snapshot_write(dst, shield.rows, SHIELD_HEIGHT);
+}
+
+static bool snapshot_read_shield(const uint8_t*& src, const Game& game, Shield* shield)
+{
+    snapshot_read(src, &shield->x);
+    snapshot_read(src, &shield->y);
+    snapshot_read(src, shield->rows, SHIELD_HEIGHT);
+    return shield->x < game.width && shield->y < game.height;
+}
+
+static void snapshot_write_bullet(uint8_t*& dst, const Bullet& bullet)
+{
+    snapshot_write(dst, &bullet.x);
+    snapshot_write(dst, &bullet.y);
+    snapshot_write(dst, &bullet.dir);
+    snapshot_write(dst, &bullet.type);
+    snapshot_write(dst, &bullet.fresh);
+}
+
+// Only the live bullets are checked, the other slots are unused
+static bool snapshot_read_bullet(const uint8_t*& src, const Game& game, bool live, Bullet* bullet)
+{
+    snapshot_read(src, &bullet->x);
+    snapshot_read(src, &bullet->y);
+    snapshot_read(src, &bullet->dir);
+    snapshot_read(src, &bullet->type);
+    bool valid = snapshot_read_bool(src, &bullet->fresh);
+    if (!live) return valid;
+
+    int dir = bullet->type == BULLET_PLAYER ? 2 * int(game.bullet_speed) : ALIEN_SHOT_DIR * int(game.bullet_speed);
+    return valid && bullet->type <= BULLET_SQUIGGLY && bullet->dir == dir &&
+        bullet->x < game.width && bullet->y < game.height;
+}
+
+static void snapshot_write_diver(uint8_t*& dst, const Diver& diver)
+{
+    snapshot_write(dst, &diver.alien);
+    snapshot_write(dst, &diver.home_x);
+    snapshot_write(dst, &diver.home_y);
+    snapshot_write(dst, &diver.distance);
+    snapshot_write(dst, &diver.path);
+}
+
+// Like snapshot_read_bullet(), only live divers are checked
+static bool snapshot_read_diver(const uint8_t*& src, const Game& game, const GameAssets& assets,
+    bool live, Diver* diver)
+{
+    snapshot_read(src, &diver->alien);
+    snapshot_read(src, &diver->home_x);
+    snapshot_read(src, &diver->home_y);
+    snapshot_read(src, &diver->distance);
+    snapshot_read(src, &diver->path);
+    if (!live) return true;
+
+    return diver->alien < game.num_aliens && diver->path < assets.dive_paths.lengths.size() &&
+        std::isfinite(diver->distance) && diver->distance >= 0 &&
+        diver->home_x < game.width && diver->home_y < game.height;
+}
+
+static void snapshot_write_alien(uint8_t*& dst, const Alien& alien)
+{
+    snapshot_write(dst, &alien.x);
+    snapshot_write(dst, &alien.y);
+    snapshot_write(dst, &alien.type);
+    snapshot_write(dst, &alien.diving);
+}
+
+static bool snapshot_read_alien(const uint8_t*& src, const Game& game, Alien* alien)
+{
+    snapshot_read(src, &alien->x);
+    snapshot_read(src, &alien->y);
+    snapshot_read(src, &alien->type);
+    bool valid = snapshot_read_bool(src, &alien->diving);
+    return valid && alien->type < AlienType::N && alien->x < game.width && alien->y < game.height;
+}
+
+size_t game_snapshot_size(const Game& game)
+{
+    return 2 * sizeof(uint32_t) +
+        11 * sizeof(size_t) +
+        2 * sizeof(uint64_t) +
+        SNAPSHOT_PLAYER_SIZE +
+        SNAPSHOT_UFO_SIZE +
+        3 * SNAPSHOT_ALIEN_SHOT_SIZE +
+        GAME_NUM_SHIELDS * SNAPSHOT_SHIELD_SIZE +
+        game.max_bullets * SNAPSHOT_BULLET_SIZE +
+        game.max_divers * SNAPSHOT_DIVER_SIZE +
+        sizeof(bool) +
+        game.num_aliens * (SNAPSHOT_ALIEN_SIZE + sizeof(uint8_t));
+}
+
+void game_snapshot(const Game& game, uint8_t* dst)
+{
+    snapshot_write(dst, &GAME_SNAPSHOT_MAGIC);
+    snapshot_write(dst, &GAME_SNAPSHOT_VERSION);
+    snapshot_write(dst, &game.width);
+    snapshot_write(dst, &game.height);
+    snapshot_write(dst, &game.num_aliens);
+    snapshot_write(dst, &game.num_columns);
+    snapshot_write(dst, &game.max_bullets);
+    snapshot_write(dst, &game.bullet_speed);
+    snapshot_write(dst, &game.max_divers);
+    snapshot_write(dst, &game.dive_interval);
+    snapshot_write(dst, &game.pixel_collisions);
+    snapshot_write(dst, &game.num_bullets);
+    snapshot_write(dst, &game.num_divers);
+    snapshot_write(dst, &game.score);
+    snapshot_write(dst, &game.tick);
+    snapshot_write(dst, &game.rng_state);
+    snapshot_write_player(dst, game.player);
+    snapshot_write_ufo(dst, game.ufo);
+    for (const auto& shot : game.alien_shots) snapshot_write_alien_shot(dst, shot);
+    for (const auto& shield : game.shields) snapshot_write_shield(dst, shield);
+
+    // The slots past the live bullets and divers hold whatever was removed
+    // last, they are written as zeros
+    for (size_t bi = 0; bi < game.max_bullets; ++bi)
+    {
+        snapshot_write_bullet(dst, bi < game.num_bullets ? game.bullets[bi] : Bullet{});
+    }
+    for (size_t di = 0; di < game.max_divers; ++di)
+    {
+        snapshot_write_diver(dst, di < game.num_divers ? game.divers[di] : Diver{});
+    }
+
+    for (const auto& alien : game.aliens) snapshot_write_alien(dst, alien);
+    snapshot_write(dst, game.death_counters.data(), game.num_aliens);
+}
+
+// Reads the state following the header of a snapshot into out. Returns false
+// if any count, index or enum is out of range. With out set to nullptr the
+// snapshot is only checked, so a corrupt one never touches the game.
+static bool snapshot_read_state(const uint8_t* src, const Game& game, const GameAssets& assets,
+    Game* out)
+{
+    size_t num_bullets, num_divers, score;
+    uint64_t tick, rng_state;
+    snapshot_read(src, &num_bullets);
+    snapshot_read(src, &num_divers);
+    snapshot_read(src, &score);
+    snapshot_read(src, &tick);
+    snapshot_read(src, &rng_state);
+    bool valid = num_bullets <= game.max_bullets && num_divers <= game.max_divers;
+
+    Player player;
+    Ufo ufo;
+    AlienShot alien_shots[3];
+    Shield shield;
+    valid &= snapshot_read_player(src, game, &player);
+    valid &= snapshot_read_ufo(src, game, &ufo);
+    for (size_t shot = 0; shot < 3; ++shot)
+    {
+        valid &= snapshot_read_alien_shot(src, shot, &alien_shots[shot]);
+    }
+
+    if (out)
+    {
+        out->num_bullets = num_bullets;
+        out->num_divers = num_divers;
+        out->score = score;
+        out->tick = tick;
+        out->rng_state = rng_state;
+        out->player = player;
+        out->ufo = ufo;
+        std::copy(alien_shots, alien_shots + 3, out->alien_shots);
+    }
+
+    for (size_t si = 0; si < GAME_NUM_SHIELDS; ++si)
+    {
+        valid &= snapshot_read_shield(src, game, out ? &out->shields[si] : &shield);
+    }
+
+    Bullet bullet;
+    for (size_t bi = 0; bi < game.max_bullets; ++bi)
+    {
+        valid &= snapshot_read_bullet(src, game, bi < num_bullets, out ? &out->bullets[bi] : &bullet);
+    }
+
+    Diver diver;
+    for (size_t di = 0; di < game.max_divers; ++di)
+    {
+        valid &= snapshot_read_diver(src, game, assets, di < num_divers, out ? &out->divers[di] : &diver);
+    }
+
+    Alien alien;
+    for (size_t ai = 0; ai < game.num_aliens; ++ai)
+    {
+        valid &= snapshot_read_alien(src, game, out ? &out->aliens[ai] : &alien);
+    }
+    if (out) snapshot_read(src, out->death_counters.data(), game.num_aliens);
+
+    return valid;
+}
+
+bool game_restore(Game* game, const GameAssets& assets, const uint8_t* src, size_t size)
+{
+    if (size != game_snapshot_size(*game)) return false;
+
+    uint32_t magic, version;
+    size_t width, height, num_aliens, num_columns, max_bullets, bullet_speed;
+    size_t max_divers, dive_interval;
+    uint8_t pixel_collisions;
+    snapshot_read(src, &magic);
+    snapshot_read(src, &version);
+    snapshot_read(src, &width);
+    snapshot_read(src, &height);
+    snapshot_read(src, &num_aliens);
+    snapshot_read(src, &num_columns);
+    snapshot_read(src, &max_bullets);
+    snapshot_read(src, &bullet_speed);
+    snapshot_read(src, &max_divers);
+    snapshot_read(src, &dive_interval);
+    snapshot_read(src, &pixel_collisions);
+
+    if (magic != GAME_SNAPSHOT_MAGIC || version != GAME_SNAPSHOT_VERSION ||
+        width != game->width || height != game->height || num_aliens != game->num_aliens ||
+        num_columns != game->num_columns || max_bullets != game->max_bullets ||
+        bullet_speed != game->bullet_speed || max_divers != game->max_divers ||
+        dive_interval != game->dive_interval || pixel_collisions != uint8_t(game->pixel_collisions))
+    {
+        return false;
+    }
+
+    if (!snapshot_read_state(src, *game, assets, nullptr)) return false;
+    snapshot_read_state(src, *game, assets, game);
+    game->num_ordered = 0;
+    std::fill(game->bullet_ranks.begin(), game->bullet_ranks.end(), BULLET_UNORDERED);
+
+    game->num_alive = 0;
+    for (const auto& alien : game->aliens)
+    {
+        game->num_alive += alien.type != ALIEN_DEAD;
+    }
+
+    for (size_t column = 0; column < game->num_columns; ++column)
+    {
+        game_update_shooter(game, column, column);
+    }
+    game->hash = game_compute_hash(*game);
+
+    return true;
+}
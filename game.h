@@ -0,0 +1,368 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "assets.h"
+#include "boxes.h"
+#include "buffer.h"
+
+enum AlienType: uint8_t
+{
+    ALIEN_DEAD = 0,
+    ALIEN_TYPE_A = 1,
+    ALIEN_TYPE_B,
+    ALIEN_TYPE_C,
+    N
+};
+
+// A position (x, y) given in pixels from the bottom left corner of the window
+struct Alien
+{
+    size_t x;
+    size_t y;
+    AlienType type;
+    // Out of the formation, see Diver
+    bool diving;
+};
+
+struct Player
+{
+    size_t x;
+    size_t y;
+    size_t life;
+};
+
+enum BulletType: uint8_t
+{
+    BULLET_PLAYER = 0,
+    // The alien shots of the original, the rolling shot aims at the player while
+    // the other two walk through a fixed sequence of columns
+    BULLET_ROLLING,
+    BULLET_PLUNGER,
+    BULLET_SQUIGGLY
+};
+
+struct Bullet
+{
+    size_t x;
+    size_t y;
+    int dir;
+    BulletType type;
+    // Fired on the last tick, its start position has not been tested yet
+    bool fresh;
+};
+
+// The mystery ship crossing the top of the screen. Its flights are scripted by
+// the front end, see game_ufo_spawn() and game_ufo_move().
+struct Ufo
+{
+    size_t x;
+    size_t y;
+    int dir;
+    bool active;
+};
+
+// Each kind of alien shot reloads on its own
+struct AlienShot
+{
+    size_t reload;
+    // Position in the column sequence, unused by the rolling shot
+    size_t column_index;
+};
+
+// An alien that left the formation and flies along one of assets.dive_paths,
+// back to its place in the formation
+struct Diver
+{
+    size_t alien;
+    size_t home_x;
+    size_t home_y;
+    // Along the path, in pixels
+    float distance;
+    uint16_t path;
+};
+
+constexpr size_t GAME_NUM_SHIELDS = 4;
+// Matches assets.shield_sprite
+constexpr size_t SHIELD_HEIGHT = 16;
+
+// A bunker whose damage is kept as a packed 1bpp bitmap, in the layout of
+// PackedSprite. Hits clear bits, see shield_erode() in game.cpp.
+struct Shield
+{
+    size_t x;
+    size_t y;
+    uint32_t rows[SHIELD_HEIGHT];
+};
+
+// Classes of the objects on screen, e.g. for labeling rendered frames
+enum EntityClass: uint8_t
+{
+    ENTITY_ALIEN_A = 0,
+    ENTITY_ALIEN_B,
+    ENTITY_ALIEN_C,
+    ENTITY_ALIEN_DYING,
+    ENTITY_BULLET,
+    ENTITY_PLAYER,
+    ENTITY_SHIELD,
+    ENTITY_UFO,
+    ENTITY_NUM_CLASSES
+};
+
+// Ids game_render() writes into Buffer::ids, the entity's class and its index,
+// e.g. of the alien or bullet. 0 is the background and the HUD.
+constexpr uint32_t GAME_ID_INDEX_BITS = 24;
+
+constexpr uint32_t game_entity_id(EntityClass type, size_t index)
+{
+    return (uint32_t(type + 1) << GAME_ID_INDEX_BITS) | uint32_t(index);
+}
+
+constexpr size_t game_entity_id_index(uint32_t id)
+{
+    return id & ((1u << GAME_ID_INDEX_BITS) - 1);
+}
+
+// Screen space bounding box of a drawn sprite, clipped to the playfield
+struct EntityBox
+{
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+    EntityClass type;
+};
+
+enum GameEventType: uint8_t
+{
+    EVENT_SHOT_FIRED = 0,
+    EVENT_ALIEN_KILLED,
+    EVENT_SCORE_CHANGED,
+    EVENT_LIFE_LOST,
+    EVENT_ALIEN_SHOT_FIRED,
+    EVENT_UFO_KILLED,
+    EVENT_SHOTS_COLLIDED,
+    EVENT_NUM_TYPES
+};
+
+// Something that happened during a tick. x and y are the position of the new
+// bullet, the killed alien or the player. value is the index of the killed
+// alien, the new score, the number of lives left, the BulletType of an alien
+// shot or the points of a UFO. Colliding shots give the position of the
+// player's shot. points is what a killed alien or UFO earned, 0 otherwise,
+// e.g. for a diver that rammed the player.
+struct GameEvent
+{
+    GameEventType type;
+    AlienType alien_type;
+    uint16_t x;
+    uint16_t y;
+    uint16_t points;
+    uint32_t value;
+};
+
+constexpr size_t GAME_MAX_EVENTS = 256;
+
+// Events of one tick, filled by game_step() when asked for
+struct GameEvents
+{
+    size_t num_events;
+    GameEvent events[GAME_MAX_EVENTS];
+};
+
+// Size of the playfield and of everything in it, fixed for the lifetime of a game
+// Upper limits of the playfield's sides and of the bullets and divers
+constexpr size_t GAME_MAX_SIZE = 16384;
+constexpr size_t GAME_MAX_OBJECTS = 1 << 20;
+
+struct GameConfig
+{
+    size_t width;
+    size_t height;
+    // Of the alien formation
+    size_t columns;
+    size_t rows;
+    size_t max_bullets;
+    // Multiplies the pixels bullets move per tick
+    size_t bullet_speed;
+    // Aliens diving at once, and ticks between two launches of divers
+    size_t max_divers;
+    size_t dive_interval;
+    // Resolve the player's shots against the aliens' pixels instead of boxes
+    bool pixel_collisions;
+
+    bool operator==(const GameConfig&) const = default;
+};
+
+// The player's controls for a single simulation tick
+struct GameInput
+{
+    int move_dir;
+    bool fire;
+};
+
+// Working memory of game_step(), sized by game_init() so stepping never
+// allocates. It is not part of the game state: the hash and snapshots leave it
+// out, and copying a game only gives the copy scratch of the same size.
+struct GameScratch
+{
+    size_t num_aliens = 0;
+    BoxSet alien_boxes = {};
+    std::vector<uint64_t> alien_box_masks;
+    // With pixel collisions, the entity ids of the living aliens' pixels in the
+    // layout of Buffer::ids, otherwise empty. Zero outside of the rows
+    // [ids_bottom, ids_top) drawn by the last step.
+    std::vector<uint32_t> alien_ids;
+    size_t ids_bottom = 0;
+    size_t ids_top = 0;
+
+    GameScratch() = default;
+    GameScratch(const GameScratch& other);
+    GameScratch(GameScratch&& other) = default;
+    GameScratch& operator=(const GameScratch& other);
+    GameScratch& operator=(GameScratch&& other) = default;
+};
+
+// The whole simulation state. Everything that changes while playing lives here,
+// so a game can be copied, snapshotted and restored as a value. The containers
+// are sized by game_init(), copying into an already initialized game of the same
+// size does not allocate.
+struct Game
+{
+    size_t width;
+    size_t height;
+    size_t num_aliens;
+    // Aliens that have not been killed yet
+    size_t num_alive;
+    // The aliens are stored row by row, starting with the bottom row
+    size_t num_columns;
+    size_t max_bullets;
+    size_t num_bullets;
+    size_t bullet_speed;
+    size_t max_divers;
+    size_t dive_interval;
+    size_t num_divers;
+    bool pixel_collisions;
+    size_t score;
+    uint64_t tick;
+    uint64_t rng_state;
+    // Zobrist hash of the living aliens and their positions, the player, the
+    // bullets and the shields, kept up to date incrementally by game_step().
+    // Cosmetic state and the score are left out.
+    uint64_t hash;
+    std::vector<Alien> aliens;
+    // The death sprite is shown for a few ticks after an alien has been hit
+    std::vector<uint8_t> death_counters;
+    // Index of the lowest living alien of each column, or num_aliens if the
+    // column is empty. These are the aliens that can shoot, unless they dive.
+    std::vector<size_t> column_shooters;
+    AlienShot alien_shots[3];
+    Player player;
+    Ufo ufo;
+    Shield shields[GAME_NUM_SHIELDS];
+    std::vector<Bullet> bullets;
+    // Indices of the bullets sorted by x, and each bullet's position in there.
+    // Kept from tick to tick since bullets never move sideways, see
+    // game_collide_bullets() in game.cpp.
+    size_t num_ordered;
+    std::vector<uint32_t> bullet_order;
+    std::vector<uint32_t> bullet_ranks;
+    std::vector<Diver> divers;
+    GameScratch scratch;
+};
+
+bool sprite_overlap_check(const Sprite& sp_a, size_t x_a, size_t y_a,
+    const Sprite& sp_b, size_t x_b, size_t y_b);
+
+// The original 224x256 playfield with 11x5 aliens
+GameConfig game_default_config();
+
+// The standard workload for scaling tests, a huge formation on a huge playfield
+GameConfig game_stress_config();
+
+// Parses argv[*i] if it is one of the playfield options shared by the
+// executables, advancing *i past its value. Returns false for other options.
+// The values are taken as given, see game_config_finish().
+bool game_config_parse_option(GameConfig* config, int argc, char** argv, int* i);
+
+// Clamps every option into its range, once all of them are known since the
+// size of the formation is limited by the playfield's
+void game_config_finish(GameConfig* config);
+
+void game_config_print_usage();
+
+void game_init(Game* game, const GameAssets& assets, const GameConfig& config, uint64_t seed);
+
+void game_seed(Game* game, uint64_t seed);
+
+// xorshift64*, cheap and good enough for gameplay decisions
+uint32_t game_random(Game* game);
+
+const Sprite& game_bullet_sprite(const GameAssets& assets, const Bullet& bullet);
+
+// The sprite an alien of the given type currently shows
+const Sprite& game_alien_sprite(const Game& game, const GameAssets& assets, AlienType type);
+
+// Recomputes the Zobrist hash from scratch
+uint64_t game_compute_hash(const Game& game);
+
+// The game ends when the player has no lives left or all aliens are dead
+bool game_is_over(const Game& game);
+
+// Starts a UFO flight from the left edge for dir > 0, otherwise from the right
+// edge. Does nothing while a UFO is flying.
+void game_ufo_spawn(Game* game, const GameAssets& assets, int dir);
+
+// Moves the UFO by its direction, it disappears once it leaves the screen.
+// Returns false if no UFO is flying, e.g. because it has been shot.
+bool game_ufo_move(Game* game, const GameAssets& assets);
+
+// Advances the game by one tick. If events is given, it is overwritten with
+// everything that happened during the tick.
+void game_step(Game* game, const GameAssets& assets, const GameInput& input,
+    GameEvents* events = nullptr);
+
+void game_render(const Game& game, const GameAssets& assets, Buffer* buffer);
+
+// Writes the bounding boxes of everything game_render() draws, apart from the
+// HUD, and returns their number. At most max_boxes are written.
+size_t game_entity_boxes(const Game& game, const GameAssets& assets,
+    EntityBox* boxes, size_t max_boxes);
+
+// A fixed-size summary of the game state for learning agents, cheaper to get
+// than a rendered frame. It is a vector of 32-bit words:
+//
+//   [GAME_OBS_PLAYER_X]         x of the player
+//   [GAME_OBS_FORMATION_X/Y]    bottom left corner of the living aliens in the
+//                               formation, 0 if there are none
+//   [GAME_OBS_NUM_BULLETS]      bullets in the list below
+//   [GAME_OBS_BULLETS + 3 * i]  x, y and BulletType of the GAME_OBS_MAX_BULLETS
+//                               lowest bullets, sorted by y, the rest is 0
+//   [GAME_OBS_ALIVE + i / 32]   bit i % 32 is set if alien i is alive
+//
+// and padded with zeros to a whole number of 64-byte cache lines.
+constexpr size_t GAME_OBS_PLAYER_X = 0;
+constexpr size_t GAME_OBS_FORMATION_X = 1;
+constexpr size_t GAME_OBS_FORMATION_Y = 2;
+constexpr size_t GAME_OBS_NUM_BULLETS = 3;
+constexpr size_t GAME_OBS_BULLETS = 4;
+constexpr size_t GAME_OBS_MAX_BULLETS = 32;
+constexpr size_t GAME_OBS_ALIVE = GAME_OBS_BULLETS + 3 * GAME_OBS_MAX_BULLETS;
+
+// In words
+size_t game_observation_size(const Game& game);
+
+// Writes game_observation_size() words
+void game_observe(const Game& game, uint32_t* observation);
+
+// Snapshots are a flat copy of the game state into caller-provided memory, equal
+// states give equal bytes. A snapshot can only be restored into a game with the
+// same configuration.
+size_t game_snapshot_size(const Game& game);
+
+void game_snapshot(const Game& game, uint8_t* dst);
+
+// Returns false, leaving game untouched, if the snapshot is of another
+// configuration or holds a count, index or enum out of range
+bool game_restore(Game* game, const GameAssets& assets, const uint8_t* src, size_t size);
@@ -0,0 +1,137 @@
+#include "invaders.h"
+
+#include <cstring>
+#include <new>
+
+#include "assets.h"
+#include "buffer.h"
+#include "game.h"
+
+struct invaders_game
+{
+    GameAssets assets;
+    Game game;
+    Buffer buffer;
+};
+
+invaders_game* invaders_create(uint64_t seed)
+{
+    // No exceptions may cross the C boundary
+    try
+    {
+        auto handle = new invaders_game;
+        assets_init(&handle->assets);
+        game_init(&handle->game, handle->assets, game_default_config(), seed);
+
+        handle->buffer.width = handle->game.width;
+        handle->buffer.height = handle->game.height;
+        handle->buffer.data = std::vector<uint32_t>(handle->buffer.width * handle->buffer.height);
+
+        return handle;
+    }
+    catch (const std::bad_alloc&)
+    {
+        return nullptr;
+    }
+}
+
+void invaders_destroy(invaders_game* game)
+{
+    delete game;
+}
+
+void invaders_set_seed(invaders_game* game, uint64_t seed)
+{
+    game_seed(&game->game, seed);
+}
+
+void invaders_step(invaders_game* game, uint32_t input)
+{
+    GameInput game_input;
+    game_input.move_dir = ((input & INVADERS_INPUT_RIGHT) ? 1 : 0) -
+        ((input & INVADERS_INPUT_LEFT) ? 1 : 0);
+    game_input.fire = (input & INVADERS_INPUT_FIRE) != 0;
+
+    game_step(&game->game, game->assets, game_input);
+}
+
+size_t invaders_score(const invaders_game* game)
+{
+    return game->game.score;
+}
+
+size_t invaders_lives(const invaders_game* game)
+{
+    return game->game.player.life;
+}
+
+void invaders_frame_size(const invaders_game* game, size_t* width, size_t* height)
+{
+    *width = game->buffer.width;
+    *height = game->buffer.height;
+}
+
+int invaders_render(invaders_game* game, uint32_t* pixels, size_t stride)
+{
+    const auto& buffer = game->buffer;
+    if (!pixels || stride < buffer.width) return -1;
+
+    game_render(game->game, game->assets, &game->buffer);
+
+    for (size_t y = 0; y < buffer.height; ++y)
+    {
+        std::memcpy(pixels + y * stride, buffer.data.data() + y * buffer.width,
+            buffer.width * sizeof(uint32_t));
+    }
+
+    return 0;
+}
+
+static_assert(INVADERS_OBS_BULLETS == GAME_OBS_BULLETS && INVADERS_OBS_MAX_BULLETS == GAME_OBS_MAX_BULLETS &&
+    INVADERS_OBS_ALIVE == GAME_OBS_ALIVE, "observation layout differs from game.h");
+
+size_t invaders_observation_size(const invaders_game* game)
+{
+    return game_observation_size(game->game);
+}
+
+int invaders_observe(invaders_game* const* games, size_t num_games, uint32_t* observations, size_t stride)
+{
+    if (num_games == 0) return 0;
+    if (!games || !observations || reinterpret_cast<uintptr_t>(observations) % 64 || stride % 16) return -1;
+
+    size_t size = game_observation_size(games[0]->game);
+    if (stride < size) return -1;
+
+    for (size_t i = 0; i < num_games; ++i)
+    {
+        if (game_observation_size(games[i]->game) != size) return -1;
+    }
+
+    for (size_t i = 0; i < num_games; ++i)
+    {
+        game_observe(games[i]->game, observations + i * stride);
+    }
+
+    return 0;
+}
+
+size_t invaders_snapshot_size(const invaders_game* game)
+{
+    return game_snapshot_size(game->game);
+}
+
+int invaders_snapshot(const invaders_game* game, void* dst, size_t size)
+{
+    if (!dst || size < game_snapshot_size(game->game)) return -1;
+
+    game_snapshot(game->game, static_cast<uint8_t*>(dst));
+    return 0;
+}
+
+int invaders_restore(invaders_game* game, const void* src, size_t size)
+{
+    if (!src) return -1;
+
+    return game_restore(&game->game, game->assets, static_cast<const uint8_t*>(src), size) ? 0 : -1;
+}
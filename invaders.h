@@ -0,0 +1,96 @@
+#ifndef INVADERS_H
+#define INVADERS_H
+
+/* C interface of libinvaders, for driving the game in-process from other
+ * languages through FFI. Apart from invaders_create(), none of the functions
+ * allocate memory. Functions returning int return 0 on success and -1 on error. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define INVADERS_API __declspec(dllexport)
+#else
+#define INVADERS_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct invaders_game invaders_game;
+
+/* Bits of the input passed to invaders_step() */
+enum
+{
+    INVADERS_INPUT_LEFT = 1,
+    INVADERS_INPUT_RIGHT = 2,
+    INVADERS_INPUT_FIRE = 4
+};
+
+/* Returns NULL if the game could not be created */
+INVADERS_API invaders_game* invaders_create(uint64_t seed);
+
+INVADERS_API void invaders_destroy(invaders_game* game);
+
+/* Reseeds the random number generator without touching the rest of the state */
+INVADERS_API void invaders_set_seed(invaders_game* game, uint64_t seed);
+
+/* Advances the simulation by one tick */
+INVADERS_API void invaders_step(invaders_game* game, uint32_t input);
+
+INVADERS_API size_t invaders_score(const invaders_game* game);
+
+INVADERS_API size_t invaders_lives(const invaders_game* game);
+
+/* Size of the rendered frame in pixels */
+INVADERS_API void invaders_frame_size(const invaders_game* game, size_t* width, size_t* height);
+
+/* Renders the current state into pixels, which has room for height rows of stride
+ * pixels each. Pixels are 0xRRGGBBAA and the first row is the bottom of the screen. */
+INVADERS_API int invaders_render(invaders_game* game, uint32_t* pixels, size_t stride);
+
+/* Word offsets into an observation, a vector of 32-bit words summarizing the
+ * state without rendering it:
+ *   [INVADERS_OBS_PLAYER_X]         x of the player
+ *   [INVADERS_OBS_FORMATION_X/Y]    bottom left corner of the living aliens in
+ *                                   the formation, 0 if there are none
+ *   [INVADERS_OBS_NUM_BULLETS]      number of bullets listed below
+ *   [INVADERS_OBS_BULLETS + 3 * i]  x, y and type (0 for the player's) of the
+ *                                   INVADERS_OBS_MAX_BULLETS lowest bullets,
+ *                                   sorted by y, the rest is 0
+ *   [INVADERS_OBS_ALIVE + i / 32]   bit i % 32 is set if alien i is alive
+ * Positions are in pixels from the bottom left corner. */
+enum
+{
+    INVADERS_OBS_PLAYER_X = 0,
+    INVADERS_OBS_FORMATION_X = 1,
+    INVADERS_OBS_FORMATION_Y = 2,
+    INVADERS_OBS_NUM_BULLETS = 3,
+    INVADERS_OBS_BULLETS = 4,
+    INVADERS_OBS_MAX_BULLETS = 32,
+    INVADERS_OBS_ALIVE = 100
+};
+
+/* Words of an observation, a multiple of 16 so each fills whole cache lines */
+INVADERS_API size_t invaders_observation_size(const invaders_game* game);
+
+/* Writes the observations of a batch of games of the same configuration, that
+ * of games[i] at observations + i * stride. observations must be 64-byte
+ * aligned and stride a multiple of 16 no smaller than invaders_observation_size(). */
+INVADERS_API int invaders_observe(invaders_game* const* games, size_t num_games,
+    uint32_t* observations, size_t stride);
+
+INVADERS_API size_t invaders_snapshot_size(const invaders_game* game);
+
+/* Writes the full game state into dst, which must hold invaders_snapshot_size() bytes */
+INVADERS_API int invaders_snapshot(const invaders_game* game, void* dst, size_t size);
+
+/* Restores a state written by invaders_snapshot() of a game with the same configuration */
+INVADERS_API int invaders_restore(invaders_game* game, const void* src, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,103 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+static void jobs_run_chunks(JobSystem* jobs, size_t worker)
+{
+    while (true)
+    {
+        size_t begin = jobs->next.fetch_add(jobs->grain, std::memory_order_relaxed);
+        if (begin >= jobs->count) break;
+
+        size_t end = std::min(begin + jobs->grain, jobs->count);
+        (*jobs->task)(begin, end, worker);
+    }
+}
+
+static void jobs_worker(JobSystem* jobs, size_t worker)
+{
+    uint64_t generation = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(jobs->mutex);
+            jobs->wake.wait(lock, [&] { return jobs->quit || jobs->generation != generation; });
+            if (jobs->quit) return;
+            generation = jobs->generation;
+        }
+
+        jobs_run_chunks(jobs, worker);
+
+        std::lock_guard lock(jobs->mutex);
+        if (--jobs->active == 0) jobs->done.notify_one();
+    }
+}
+
+void jobs_init(JobSystem* jobs, size_t num_workers)
+{
+    if (num_workers == 0) num_workers = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t num_threads = num_workers - 1;
+
+    jobs->task = nullptr;
+    jobs->count = 0;
+    jobs->grain = 1;
+    jobs->next = 0;
+    jobs->active = 0;
+    jobs->generation = 0;
+    jobs->quit = false;
+
+    for (size_t i = 0; i < num_threads; ++i)
+    {
+        jobs->threads.emplace_back(jobs_worker, jobs, i + 1);
+    }
+}
+
+void jobs_shutdown(JobSystem* jobs)
+{
+    {
+        std::lock_guard lock(jobs->mutex);
+        jobs->quit = true;
+    }
+    jobs->wake.notify_all();
+
+    for (auto& thread : jobs->threads)
+    {
+        thread.join();
+    }
+    jobs->threads.clear();
+}
+
+size_t jobs_num_workers(const JobSystem& jobs)
+{
+    return jobs.threads.size() + 1;
+}
+
+void jobs_parallel_for(JobSystem* jobs, size_t count, size_t grain, const JobSystem::Task& task)
+{
+    if (count == 0) return;
+
+    // Not worth waking anybody up for a single chunk
+    if (jobs->threads.empty() || count <= grain)
+    {
+        task(0, count, 0);
+        return;
+    }
+
+    {
+        std::lock_guard lock(jobs->mutex);
+        jobs->task = &task;
+        jobs->count = count;
+        jobs->grain = std::max<size_t>(grain, 1);
+        jobs->next.store(0, std::memory_order_relaxed);
+        jobs->active = jobs->threads.size();
+        ++jobs->generation;
+    }
+    jobs->wake.notify_all();
+
+    jobs_run_chunks(jobs, 0);
+
+    std::unique_lock lock(jobs->mutex);
+    jobs->done.wait(lock, [&] { return jobs->active == 0; });
+    jobs->task = nullptr;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Called with a chunk [begin, end) and the index of the worker running it, in
+// [0, jobs_num_workers()). The calling thread is worker 0.
+//
+// Only refers to the callable instead of copying it, so passing a lambda never
+// allocates. The callable has to outlive the jobs_parallel_for() it is passed
+// to, which a lambda written into the call does.
+struct JobTask
+{
+    const void* callable;
+    void (*call)(const void* callable, size_t begin, size_t end, size_t worker);
+
+    template <typename F>
+    JobTask(const F& f)
+        : callable(&f),
+          call([](const void* callable, size_t begin, size_t end, size_t worker)
+              { (*static_cast<const F*>(callable))(begin, end, worker); })
+    {
+    }
+
+    void operator()(size_t begin, size_t end, size_t worker) const
+    {
+        call(callable, begin, end, worker);
+    }
+};
+
+// A minimal fork-join thread pool. jobs_parallel_for() splits a range into
+// chunks which the worker threads and the calling thread pick up until the
+// range is exhausted. Only one parallel_for may run at a time.
+struct JobSystem
+{
+    using Task = JobTask;
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    const Task* task;
+    size_t count;
+    size_t grain;
+    std::atomic<size_t> next;
+    size_t active;
+    uint64_t generation;
+    bool quit;
+};
+
+// num_workers counts the calling thread too, 0 picks the number of CPUs
+void jobs_init(JobSystem* jobs, size_t num_workers = 0);
+
+void jobs_shutdown(JobSystem* jobs);
+
+size_t jobs_num_workers(const JobSystem& jobs);
+
+void jobs_parallel_for(JobSystem* jobs, size_t count, size_t grain, const JobSystem::Task& task);
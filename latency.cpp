@@ -0,0 +1,120 @@
+#include "latency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <print>
+
+static const char* latency_stage_names[LATENCY_NUM_STAGES] = { "tick", "render", "upload", "gpu", "swap" };
+
+uint64_t latency_now()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+}
+
+void latency_init(LatencyTracker* latency)
+{
+    latency->samples.clear();
+    latency->current = SIZE_MAX;
+
+    // Core in 3.3, which the window asks for
+    latency->gpu_timestamps = GLEW_ARB_timer_query || GLEW_VERSION_3_3;
+    latency->gpu_offset = 0;
+    if (latency->gpu_timestamps)
+    {
+        glGenQueries(LATENCY_NUM_QUERIES, latency->queries);
+
+        // The GPU clock has its own origin, both clocks count nanoseconds
+        GLint64 gpu_time = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpu_time);
+        latency->gpu_offset = int64_t(latency_now()) - gpu_time;
+    }
+
+    for (auto& sample : latency->query_samples)
+    {
+        sample = SIZE_MAX;
+    }
+}
+
+void latency_shutdown(LatencyTracker* latency)
+{
+    if (latency->gpu_timestamps) glDeleteQueries(LATENCY_NUM_QUERIES, latency->queries);
+}
+
+void latency_tick(LatencyTracker* latency, uint64_t input_time)
+{
+    LatencySample sample = {};
+    sample.input = input_time;
+    sample.stages[LATENCY_TICK] = latency_now();
+
+    latency->current = latency->samples.size();
+    latency->samples.push_back(sample);
+}
+
+void latency_stage(LatencyTracker* latency, LatencyStage stage)
+{
+    if (latency->current == SIZE_MAX) return;
+
+    // A sample waiting for an uploaded frame sees the stages of several frames,
+    // the first one counts
+    auto& time = latency->samples[latency->current].stages[stage];
+    if (!time) time = latency_now();
+    if (stage == LATENCY_SWAP) latency->current = SIZE_MAX;
+}
+
+void latency_gpu_mark(LatencyTracker* latency)
+{
+    if (!latency->gpu_timestamps || latency->current == SIZE_MAX) return;
+
+    // With every query in flight this sample goes without a GPU time
+    for (size_t q = 0; q < LATENCY_NUM_QUERIES; ++q)
+    {
+        if (latency->query_samples[q] != SIZE_MAX) continue;
+
+        glQueryCounter(latency->queries[q], GL_TIMESTAMP);
+        latency->query_samples[q] = latency->current;
+        return;
+    }
+}
+
+void latency_poll(LatencyTracker* latency)
+{
+    if (!latency->gpu_timestamps) return;
+
+    for (size_t q = 0; q < LATENCY_NUM_QUERIES; ++q)
+    {
+        size_t si = latency->query_samples[q];
+        if (si == SIZE_MAX) continue;
+
+        GLint available = 0;
+        glGetQueryObjectiv(latency->queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) continue;
+
+        GLuint64 gpu_time = 0;
+        glGetQueryObjectui64v(latency->queries[q], GL_QUERY_RESULT, &gpu_time);
+        latency->samples[si].stages[LATENCY_GPU] = uint64_t(int64_t(gpu_time) + latency->gpu_offset);
+        latency->query_samples[q] = SIZE_MAX;
+    }
+}
+
+void latency_report(const LatencyTracker& latency)
+{
+    std::println("Input latency over {} inputs, milliseconds from the key press:", latency.samples.size());
+    std::println("{:>8} {:>8} {:>8} {:>8} {:>8} {:>8}", "stage", "samples", "p50", "p90", "p99", "max");
+
+    std::vector<uint64_t> times;
+    for (size_t stage = 0; stage < LATENCY_NUM_STAGES; ++stage)
+    {
+        times.clear();
+        for (const auto& sample : latency.samples)
+        {
+            if (sample.stages[stage] >= sample.input) times.push_back(sample.stages[stage] - sample.input);
+        }
+        if (times.empty()) continue;
+
+        std::sort(times.begin(), times.end());
+        auto percentile = [&times](size_t p) { return times[(times.size() - 1) * p / 100] / 1e6; };
+        std::println("{:>8} {:>8} {:>8.2f} {:>8.2f} {:>8.2f} {:>8.2f}", latency_stage_names[stage], times.size(),
+            percentile(50), percentile(90), percentile(99), times.back() / 1e6);
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+// Measures the time from a key press to the frame showing its effect.
+//
+// The key callback stamps the first input since the last tick, the tick that
+// consumes it opens a sample, and the next frame adds a timestamp after each
+// of its stages. Where the driver has timer queries, a GL timestamp marks
+// when the GPU finished drawing the frame. It is converted to the CPU clock
+// and arrives a few frames later. latency_report() prints the distribution
+// of the time from the input to the end of every stage.
+
+enum LatencyStage: uint8_t
+{
+    // game_step() consumed the input
+    LATENCY_TICK = 0,
+    // The frame was drawn into the buffer
+    LATENCY_RENDER,
+    // The frame's pixels were handed to GL, or with the async uploader, its
+    // upload fence signaled and the frame was drawn
+    LATENCY_UPLOAD,
+    // The GPU finished drawing
+    LATENCY_GPU,
+    // glfwSwapBuffers() returned
+    LATENCY_SWAP,
+    LATENCY_NUM_STAGES
+};
+
+constexpr size_t LATENCY_NUM_QUERIES = 8;
+
+// Nanoseconds on the steady clock, 0 for a stage not reached
+struct LatencySample
+{
+    uint64_t input;
+    uint64_t stages[LATENCY_NUM_STAGES];
+};
+
+struct LatencyTracker
+{
+    std::vector<LatencySample> samples;
+    // Waiting for its frame, or SIZE_MAX
+    size_t current;
+
+    bool gpu_timestamps;
+    // GPU time + offset = CPU time
+    int64_t gpu_offset;
+    GLuint queries[LATENCY_NUM_QUERIES];
+    // Sample each query belongs to, or SIZE_MAX if the query is free
+    size_t query_samples[LATENCY_NUM_QUERIES];
+};
+
+uint64_t latency_now();
+
+// Needs a current GL context for the timer queries
+void latency_init(LatencyTracker* latency);
+
+void latency_shutdown(LatencyTracker* latency);
+
+// Opens a sample for an input consumed by the tick that just ended
+void latency_tick(LatencyTracker* latency, uint64_t input_time);
+
+// Stamps a stage of the frame showing the open sample, a stage only once.
+// LATENCY_SWAP closes it.
+void latency_stage(LatencyTracker* latency, LatencyStage stage);
+
+// Issues a GL timestamp query after the frame's draw calls
+void latency_gpu_mark(LatencyTracker* latency);
+
+// Collects the timer queries that have finished, call once a frame
+void latency_poll(LatencyTracker* latency);
+
+void latency_report(const LatencyTracker& latency);
@@ -1,169 +1,29 @@
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <memory>
 #include <print>
 #include <vector>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 
-struct Buffer
-{
-    size_t width;
-    size_t height;
-    std::vector<uint32_t> data;
-};
-
-struct Sprite
-{
-    size_t width;
-    size_t height;
-    std::vector<uint8_t> data;
-};
-
-enum AlienType: uint8_t
-{
-    ALIEN_DEAD = 0,
-    ALIEN_TYPE_A = 1,
-    ALIEN_TYPE_B,
-    ALIEN_TYPE_C,
-    N
-};
-
-// A position (x, y) given in pixels from the bottom left corner of the window
-struct Alien
-{
-    size_t x;
-    size_t y;
-    AlienType type;
-};
-
-struct Player
-{
-    size_t x;
-    size_t y;
-    size_t life;
-};
-
-struct Bullet
-{
-    size_t x;
-    size_t y;
-    int dir;
-};
-
-constexpr size_t GAME_MAX_BULLETS = 128;
-
-struct Game
-{
-    size_t width;
-    size_t height;
-    size_t num_aliens;
-    size_t num_bullets;
-    std::vector<Alien> aliens;
-    Player player;
-    Bullet bullets[GAME_MAX_BULLETS];
-};
-
-struct SpriteAnimation
-{
-    bool loop;
-    size_t num_frames;
-    size_t frame_duration;
-    size_t time;
-    std::vector<Sprite> frames;
-};
-
-bool sprite_overlap_check(const Sprite& sp_a, size_t x_a, size_t y_a,
-    const Sprite& sp_b, size_t x_b, size_t y_b)
-{
-    return (x_a < (x_b + sp_b.width) && (x_a + sp_a.width) > x_b &&
-        y_a < (y_b + sp_b.height) && (y_a + sp_a.height) > y_b);
-}
-
-constexpr uint32_t rgb_to_uint32(uint8_t r, uint8_t g, uint8_t b)
-{
-    return ((r << 24) | (g << 16) | (b << 8) | 255);
-}
-
-void buffer_clear(Buffer* buffer, uint32_t color)
-{
-    for (size_t i = 0; i < buffer->width * buffer->height; ++i)
-    {
-        buffer->data[i] = color;
-    }
-}
-
-void buffer_draw_sprite(Buffer* buffer, const Sprite& sprite,
-    size_t x, size_t y, uint32_t color)
-{
-    for (size_t xi = 0; xi < sprite.width; ++xi)
-    {
-        for (size_t yi = 0; yi < sprite.height; ++yi)
-        {
-            size_t sy = sprite.height - 1 + y - yi;
-            size_t sx = x + xi;
-
-            if (sprite.data[yi * sprite.width + xi] &&
-                sy < buffer->height && 
-                sx < buffer->width)
-            {
-                buffer->data[sy * buffer->width + sx] = color;
-            }
-        }
-    }
-}
-
-// We define a new spritesheet containing 65 5x7 ASCII character sprites starting from 'space',
-// which has the value of 32 in ASCII, up to character '`', which has ASCII value 96.
-// Note that we only include uppercase letters and a few special characters.
-void buffer_draw_text(Buffer* buffer, const Sprite& text_spritesheet, const char* text,
-    size_t x, size_t y, uint32_t color)
-{
-    size_t xp = x;
-    size_t stride = text_spritesheet.width * text_spritesheet.height;
-    Sprite sprite;
-    sprite.height = text_spritesheet.height;
-    sprite.width = text_spritesheet.width;
-
-    for (auto charp = text; *charp != '\0'; ++charp)
-    {
-        char character = *charp - 32;
-        if (character < 0 || character >= 65) continue;
-
-        sprite.data = std::vector(text_spritesheet.data.begin() + character * stride,
-            text_spritesheet.data.begin() + (character + 1) * stride);
-        buffer_draw_sprite(buffer, sprite, xp, y, color);
-        xp += sprite.width + 1;
-    }
-}
-
-void buffer_draw_number(Buffer* buffer, const Sprite& number_spritesheet, size_t number,
-    size_t x, size_t y, uint32_t color)
-{
-    std::array<uint8_t, 64> digits;
-    size_t num_digits = 0;
-
-    size_t current_number = number;
-    do
-    {
-        digits[num_digits++] = current_number % 10;
-        current_number = current_number / 10;
-    } while (current_number > 0);
-    
-    size_t xp = x;
-    size_t stride = number_spritesheet.width * number_spritesheet.height;
-    Sprite sprite;
-    sprite.height = number_spritesheet.height;
-    sprite.width = number_spritesheet.width;
-
-    for (size_t i = 0; i < num_digits; ++i)
-    {
-        auto digit = digits[num_digits - i - 1];
-        sprite.data = std::vector(number_spritesheet.data.begin() + digit * stride, 
-            number_spritesheet.data.begin() + (digit + 1) * stride);
-        buffer_draw_sprite(buffer, sprite, xp, y, color);
-        xp += sprite.width + 1;
-    }
-}
+#include "assets.h"
+#include "audio.h"
+#include "behavior.h"
+#include "bot.h"
+#include "buffer.h"
+#include "effects.h"
+#include "events.h"
+#include "game.h"
+#include "jobs.h"
+#include "latency.h"
+#include "particles.h"
+#include "replay.h"
+#include "scripts.h"
+#include "telemetry.h"
+#include "upload.h"
+#include "viewport.h"
 
 void validate_shader(GLuint shader, const char* file = 0)
 {
@@ -205,11 +65,15 @@ void error_callback(int error, const char* description)
 bool game_running = false;
 int move_dir = 0;
 bool fire_pressed = 0;
-size_t score = 0;
+// When the first input since the last tick arrived, 0 if there was none
+uint64_t input_time = 0;
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action,
     int modes /* Shift, Ctrl, etc. */)
 {
+    bool game_key = key == GLFW_KEY_RIGHT || key == GLFW_KEY_LEFT || key == GLFW_KEY_SPACE;
+    if (game_key && action != GLFW_REPEAT && !input_time) input_time = latency_now();
+
     switch (key)
     {
     case GLFW_KEY_ESCAPE:
@@ -231,13 +95,52 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action,
     }
 }
 
+// Set by the framebuffer size callback, the backbuffer itself is resized by GLFW
+int framebuffer_width = 0;
+int framebuffer_height = 0;
+bool framebuffer_resized = true;
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    framebuffer_width = width;
+    framebuffer_height = height;
+    framebuffer_resized = true;
+}
+
 // https://nicktasios.nl/posts/space-invaders-from-scratch-part-1.html
 // https://github.com/Grieverheart/space_invaders
 
 int main(int argc, char** argv)
 {
-    constexpr auto buffer_width = 224;
-    constexpr auto buffer_height = 256;
+    // In attract mode the game plays itself using the search bot
+    bool attract = false;
+    const char* telemetry_path = nullptr;
+    const char* replay_path = nullptr;
+    const char* audio_path = nullptr;
+    // Scale up with a framebuffer blit instead of drawing a textured triangle
+    bool blit = false;
+    // Upload the frames from a worker thread with its own GL context
+    bool async_upload = false;
+    // Time each input through the stages of the frame that shows it
+    bool measure_latency = false;
+    auto game_config = game_default_config();
+    for (int i = 1; i < argc; ++i)
+    {
+        if (!std::strcmp(argv[i], "--attract")) attract = true;
+        else if (!std::strcmp(argv[i], "--telemetry") && i + 1 < argc) telemetry_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--record") && i + 1 < argc) replay_path = argv[++i];
+        else if (!std::strcmp(argv[i], "--blit")) blit = true;
+        else if (!std::strcmp(argv[i], "--async-upload")) async_upload = true;
+        else if (!std::strcmp(argv[i], "--latency")) measure_latency = true;
+        else if (!std::strcmp(argv[i], "--audio-wav") && i + 1 < argc) audio_path = argv[++i];
+        else if (!game_config_parse_option(&game_config, argc, argv, &i))
+        {
+            std::println("Usage: invaders [--attract] [--telemetry FILE] [--record FILE] [--audio-wav FILE] [--blit] [--async-upload] [--latency] [options]");
+            game_config_print_usage();
+            return -1;
+        }
+    }
+    game_config_finish(&game_config);
 
     glfwSetErrorCallback(error_callback);
 
@@ -251,7 +154,10 @@ int main(int argc, char** argv)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 
-    auto window = glfwCreateWindow(640, 480, "Space Invaders", NULL, NULL);
+    // Twice the size of the playfield, as long as that fits on a typical screen
+    int window_width = int(std::min<size_t>(2 * game_config.width, 1024));
+    int window_height = int(std::min<size_t>(2 * game_config.height, 1024));
+    auto window = glfwCreateWindow(window_width, window_height, "Space Invaders", NULL, NULL);
 
     if (!window)
     {
@@ -261,6 +167,9 @@ int main(int argc, char** argv)
 
     glfwMakeContextCurrent(window);
     glfwSetKeyCallback(window, key_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    // On high DPI displays this differs from the window size
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
 
     auto err = glewInit();
 
@@ -274,11 +183,11 @@ int main(int argc, char** argv)
     // Turn on V-sync, an option wherein video card updates are synchronized with the monitor refresh rate, e.g., 60 Hz
     glfwSwapInterval(1);
 
-    glClearColor(1.0, 0.0, 0.0, 1.0);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
 
     Buffer buffer;
-    buffer.width = buffer_width;
-    buffer.height = buffer_height;
+    buffer.width = game_config.width;
+    buffer.height = game_config.height;
     buffer.data = std::vector<uint32_t>(buffer.width * buffer.height);
     buffer_clear(&buffer, 0);
 
@@ -373,414 +282,279 @@ void main(void) {
 
     glBindVertexArray(fullscreen_triangle_vao);
 
-    Sprite alien_sprites[6];
-
-    alien_sprites[0].width = 8;
-    alien_sprites[0].height = 8;
-    alien_sprites[0].data = std::vector<uint8_t> 
-    {
-        0,0,0,1,1,0,0,0, // ...@@...
-        0,0,1,1,1,1,0,0, // ..@@@@..
-        0,1,1,1,1,1,1,0, // .@@@@@@.
-        1,1,0,1,1,0,1,1, // @@.@@.@@
-        1,1,1,1,1,1,1,1, // @@@@@@@@
-        0,1,0,1,1,0,1,0, // .@.@@.@.
-        1,0,0,0,0,0,0,1, // @......@
-        0,1,0,0,0,0,1,0  // .@....@.
-    };
-
-    alien_sprites[1].width = 8;
-    alien_sprites[1].height = 8;
-    alien_sprites[1].data = std::vector<uint8_t>
-    {
-        0,0,0,1,1,0,0,0, // ...@@...
-        0,0,1,1,1,1,0,0, // ..@@@@..
-        0,1,1,1,1,1,1,0, // .@@@@@@.
-        1,1,0,1,1,0,1,1, // @@.@@.@@
-        1,1,1,1,1,1,1,1, // @@@@@@@@
-        0,0,1,0,0,1,0,0, // ..@..@..
-        0,1,0,1,1,0,1,0, // .@.@@.@.
-        1,0,1,0,0,1,0,1  // @.@..@.@
-    };
-
-    alien_sprites[2].width = 11;
-    alien_sprites[2].height = 8;
-    alien_sprites[2].data = std::vector<uint8_t>
-    {
-        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-        0,0,0,1,0,0,0,1,0,0,0, // ...@...@...
-        0,0,1,1,1,1,1,1,1,0,0, // ..@@@@@@@..
-        0,1,1,0,1,1,1,0,1,1,0, // .@@.@@@.@@.
-        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-        1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
-        1,0,1,0,0,0,0,0,1,0,1, // @.@.....@.@
-        0,0,0,1,1,0,1,1,0,0,0  // ...@@.@@...
-    };
-
-    alien_sprites[3].width = 11;
-    alien_sprites[3].height = 8;
-    alien_sprites[3].data = std::vector<uint8_t>
-    {
-        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-        1,0,0,1,0,0,0,1,0,0,1, // @..@...@..@
-        1,0,1,1,1,1,1,1,1,0,1, // @.@@@@@@@.@
-        1,1,1,0,1,1,1,0,1,1,1, // @@@.@@@.@@@
-        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-        0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
-        0,0,1,0,0,0,0,0,1,0,0, // ..@.....@..
-        0,1,0,0,0,0,0,0,0,1,0  // .@.......@.
-    };
-
-    alien_sprites[4].width = 12;
-    alien_sprites[4].height = 8;
-    alien_sprites[4].data = std::vector<uint8_t>
+    // The blit reads the buffer texture through a framebuffer object
+    GLuint buffer_fbo = 0;
+    if (blit)
     {
-        0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
-        0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
-        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-        1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
-        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-        0,0,0,1,1,0,0,1,1,0,0,0, // ...@@..@@...
-        0,0,1,1,0,1,1,0,1,1,0,0, // ..@@.@@.@@..
-        1,1,0,0,0,0,0,0,0,0,1,1  // @@........@@
-    };
-
-
-    alien_sprites[5].width = 12;
-    alien_sprites[5].height = 8;
-    alien_sprites[5].data = std::vector<uint8_t>
-    {
-        0,0,0,0,1,1,1,1,0,0,0,0, // ....@@@@....
-        0,1,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@@.
-        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-        1,1,1,0,0,1,1,0,0,1,1,1, // @@@..@@..@@@
-        1,1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@@
-        0,0,1,1,1,0,0,1,1,1,0,0, // ..@@@..@@@..
-        0,1,1,0,0,1,1,0,0,1,1,0, // .@@..@@..@@.
-        0,0,1,1,0,0,0,0,1,1,0,0  // ..@@....@@..
-    };
-
-    Sprite alien_death_sprite;
-    alien_death_sprite.width = 13;
-    alien_death_sprite.height = 7;
-    alien_death_sprite.data = std::vector<uint8_t>
-    {
-        0,1,0,0,1,0,0,0,1,0,0,1,0, // .@..@...@..@.
-        0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
-        0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
-        1,1,0,0,0,0,0,0,0,0,0,1,1, // @@.........@@
-        0,0,0,1,0,0,0,0,0,1,0,0,0, // ...@.....@...
-        0,0,1,0,0,1,0,1,0,0,1,0,0, // ..@..@.@..@..
-        0,1,0,0,1,0,0,0,1,0,0,1,0  // .@..@...@..@.
-    };
-
-    std::vector<SpriteAnimation> alien_animation(3);
-
-    for (size_t i = 0; i < 3; ++i)
-    {
-        alien_animation[i].loop = true;
-        alien_animation[i].num_frames = 2;
-        alien_animation[i].frame_duration = 10;
-        alien_animation[i].time = 0;
+        glGenFramebuffers(1, &buffer_fbo);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer_fbo);
+        glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer_texture, 0);
 
-        alien_animation[i].frames = std::vector<Sprite>(
-            { alien_sprites[2 * i], alien_sprites[2 * i + 1] });
+        if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            std::println("Framebuffer incomplete, drawing without blit.");
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+            glDeleteFramebuffers(1, &buffer_fbo);
+            buffer_fbo = 0;
+            blit = false;
+        }
     }
 
-    Sprite player_sprite;
-    player_sprite.width = 11;
-    player_sprite.height = 7;
-    player_sprite.data = std::vector<uint8_t>
-    {
-        0,0,0,0,0,1,0,0,0,0,0, // .....@.....
-        0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
-        0,0,0,0,1,1,1,0,0,0,0, // ....@@@....
-        0,1,1,1,1,1,1,1,1,1,0, // .@@@@@@@@@.
-        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-        1,1,1,1,1,1,1,1,1,1,1, // @@@@@@@@@@@
-    };
-
-    Sprite text_spritesheet;
-    text_spritesheet.width = 5;
-    text_spritesheet.height = 7;
-    text_spritesheet.data = std::vector<uint8_t> // 65 chars x 35 pixels each
+    TextureUploader uploader;
+    if (async_upload && !uploader_init(&uploader, window, buffer.width, buffer.height))
     {
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,1,0,1,0,0,1,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,1,0,1,0,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,1,1,1,1,1,0,1,0,1,0,0,1,0,1,0,
-        0,0,1,0,0,0,1,1,1,0,1,0,1,0,0,0,1,1,1,0,0,0,1,0,1,0,1,1,1,0,0,0,1,0,0,
-        1,1,0,1,0,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,0,1,0,1,1,
-        0,1,1,0,0,1,0,0,1,0,1,0,0,1,0,0,1,1,0,0,1,0,0,1,0,1,0,0,0,1,0,1,1,1,1,
-        0,0,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
-        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
-        0,0,1,0,0,1,0,1,0,1,0,1,1,1,0,0,0,1,0,0,0,1,1,1,0,1,0,1,0,1,0,0,1,0,0,
-        0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,
-
-        0,1,1,1,0,1,0,0,0,1,1,0,0,1,1,1,0,1,0,1,1,1,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,1,0,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,0,0,1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,0,1,1,1,1,1,0,0,0,1,0,0,0,0,1,0,
-        1,1,1,1,1,1,0,0,0,0,1,1,1,1,0,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,0,1,1,1,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-
-        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0,0,1,0,0,
-        0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,
-        0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,1,1,1,1,1,0,0,0,0,0,0,0,0,0,0,
-        1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,0,0,0,0,0,1,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,1,0,1,1,1,0,1,1,1,0,1,0,0,1,0,0,0,1,0,1,1,1,0,
-
-        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,
-        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,1,1,1,1,1,0,0,0,0,1,0,0,0,0,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,1,0,1,1,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,1,1,1,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
-        0,1,1,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,1,1,1,0,
-        0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,1,0,1,0,1,0,0,1,1,0,0,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
-        1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,1,1,1,1,
-        1,0,0,0,1,1,1,0,1,1,1,0,1,0,1,1,0,1,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,1,1,0,0,1,1,0,1,0,1,1,0,0,1,1,1,0,0,0,1,1,0,0,0,1,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,0,1,1,0,1,1,1,1,
-        1,1,1,1,0,1,0,0,0,1,1,0,0,0,1,1,1,1,1,0,1,0,1,0,0,1,0,0,1,0,1,0,0,0,1,
-        0,1,1,1,0,1,0,0,0,1,1,0,0,0,0,0,1,1,1,0,1,0,0,0,1,0,0,0,0,1,0,1,1,1,0,
-        1,1,1,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,1,1,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,
-        1,0,0,0,1,1,0,0,0,1,1,0,0,0,1,1,0,1,0,1,1,0,1,0,1,1,1,0,1,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,1,0,0,0,1,
-        1,0,0,0,1,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,
-        1,1,1,1,1,0,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,1,0,0,0,0,1,1,1,1,1,
-
-        0,0,0,1,1,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,1,
-        0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,0,1,0,0,0,0,1,0,
-        1,1,0,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,0,0,1,0,0,1,1,0,0,0,
-        0,0,1,0,0,0,1,0,1,0,1,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
-        0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,1,1,1,1,1,
-        0,0,1,0,0,0,0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
-    };
-
-    Sprite number_spritesheet;
-    number_spritesheet.width = 5;
-    number_spritesheet.height = 7;
-    number_spritesheet.data = std::vector(text_spritesheet.data.begin() + 16 * 35, text_spritesheet.data.end());
-
-    Sprite bullet_sprite;
-    bullet_sprite.width = 1;
-    bullet_sprite.height = 3;
-    bullet_sprite.data =std::vector<uint8_t>
-    {
-        1, // @
-        1, // @
-        1  // @
-    };
+        std::println("Error creating a shared context, uploading on the main thread.");
+        async_upload = false;
+    }
+    GLuint attached_texture = buffer_texture;
+
+    LatencyTracker latency;
+    if (measure_latency) latency_init(&latency);
+    // With the async uploader a frame shows up once its upload fence has
+    // signaled, a few frames after it was submitted. The open sample waits for
+    // this frame, the first one submitted since the last sample was shown.
+    uint64_t latency_frame = 0;
+
+    Viewport viewport;
+
+    GameAssets assets;
+    assets_init(&assets);
 
     Game game;
-    game.width = buffer_width;
-    game.height = buffer_height;
-    game.num_aliens = 55;
-    game.num_bullets = 0;
-    game.aliens = std::vector<Alien>(game.num_aliens);
-    game.player.x = 112 - 5;
-    game.player.y = 32;
-    game.player.life = 3;
-
-    for (size_t yi = 0; yi < 5; ++yi)
+    uint64_t seed = glfwGetTimerValue();
+    game_init(&game, assets, game_config, seed);
+
+    JobSystem jobs;
+    jobs_init(&jobs);
+
+    Bot bot;
+    if (attract) bot_init(&bot, bot_default_config(), assets, &jobs, game);
+
+    Particles particles;
+    particles_init(&particles, 1 << 17, glfwGetTimerValue());
+
+    Effects effects;
+    effects_init(&effects);
+
+    BehaviorScheduler behaviors;
+    behavior_init(&behaviors);
+    behavior_spawn(&behaviors, ufo_flyovers(&game, &assets, glfwGetTimerValue()));
+
+    // The cosmetic systems pick up the events of each tick in their own phase
+    EventBus event_bus;
+    event_bus_init(&event_bus);
+    size_t particle_events = event_bus_subscribe(&event_bus, 4096);
+    size_t effect_events = event_bus_subscribe(&event_bus, 4096);
+
+    TelemetryLog telemetry;
+    GameEvents events;
+    GameEvents event_batch;
+    uint64_t game_id = 0;
+    if (telemetry_path && !telemetry_open(&telemetry, telemetry_path))
     {
-        for (size_t xi = 0; xi < 11; ++xi)
-        {
-            auto& alien = game.aliens[yi * 11 + xi];
-            alien.type = static_cast<AlienType>((5 - yi) / 2 + 1);
+        std::println("Error opening telemetry log {}", telemetry_path);
+        telemetry_path = nullptr;
+    }
 
-            auto& sprite = alien_sprites[2 * (alien.type - 1)];
-            alien.x = 16 * xi + 20 + (alien_death_sprite.width - sprite.width)/2;
-            alien.y = 17 * yi + 128;
+    ReplayWriter replay;
+    if (replay_path)
+    {
+        if (replay_open(&replay, replay_path, game_config)) replay_begin_game(&replay, seed);
+        else
+        {
+            std::println("Error opening replay {}", replay_path);
+            replay_path = nullptr;
         }
     }
 
-    auto death_counters = std::vector<uint8_t>(game.num_aliens, 10);
+    // Sound goes to the file if one is given, otherwise to the audio device.
+    // Without either no audio thread runs.
+    Audio audio;
+    bool audio_enabled = audio_init(&audio, audio_path ? AUDIO_BACKEND_WAV : AUDIO_BACKEND_DEVICE, audio_path);
+    if (!audio_enabled && audio_path)
+    {
+        std::println("Error opening audio file {}", audio_path);
+        audio_path = nullptr;
+    }
+    // Audio picks up the tick's events from the bus like the cosmetic systems
+    size_t audio_events = audio_enabled ? event_bus_subscribe(&event_bus, 4096) : 0;
+
+    auto start_time = std::chrono::steady_clock::now();
 
     // Game loop
-    auto clear_color = rgb_to_uint32(0, 0, 0);
     game_running = true;
 
     while(!glfwWindowShouldClose(window) && game_running)
     {
-        buffer_clear(&buffer, clear_color);
-
-        buffer_draw_text(&buffer, text_spritesheet, "SCORE", 4,
-            game.height - text_spritesheet.height - 7, rgb_to_uint32(128, 0, 0));
-        
-        buffer_draw_number(&buffer, number_spritesheet, score,
-            4 + 2 * number_spritesheet.width,
-            game.height - 2 * number_spritesheet.height - 12,
-            rgb_to_uint32(128, 0, 0));
-        
-        // Credits and a horizontal line above the credit text
-        buffer_draw_text(&buffer, text_spritesheet, "CREDIT 00", 164, 7,
-            rgb_to_uint32(128, 0, 0));
-        
-        for (size_t i = 0; i < game.width; ++i)
-        {
-            buffer.data[game.width * 16 + i] = rgb_to_uint32(128, 0, 0);
-        }
+        game_render(game, assets, &buffer);
+        particles_render(particles, &buffer);
+        effects_render(effects, assets, &buffer, game.tick);
+        if (measure_latency) latency_stage(&latency, LATENCY_RENDER);
 
-        for (size_t ai = 0; ai < game.num_aliens; ++ai)
+        bool frame_shown = true;
+        if (async_upload)
         {
-            /* If an alien is dead, we decrement the death counter,
-            and "remove" the alien from the game when the counter reaches 0. 
-            When drawing the aliens, we now need to check if the death counter 
-            is bigger than 0, otherwise we don't have to draw the alien. 
-            This way, the death sprite is shown for 10 frames.*/
-            if (!death_counters[ai]) continue;
-    
-            const auto& alien = game.aliens[ai];
-
-            if (alien.type == ALIEN_DEAD)
-            {
-                buffer_draw_sprite(&buffer, alien_death_sprite, alien.x, alien.y,
-                    rgb_to_uint32(128, 0, 0));
-            }
-            else
+            uint64_t frame = uploader_submit(&uploader, &buffer);
+            if (!latency_frame) latency_frame = frame;
+
+            // Rebinding also makes the worker's writes visible in this context
+            GLuint texture = uploader_texture(&uploader);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            if (blit && texture != attached_texture)
             {
-                const auto& animation = alien_animation[alien.type - 1];
-                size_t current_frame = animation.time / animation.frame_duration;
-                const auto& sprite = animation.frames[current_frame];
-                buffer_draw_sprite(&buffer, sprite, alien.x, alien.y,
-                    rgb_to_uint32(128, 0, 0));
+                glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture, 0);
+                attached_texture = texture;
             }
+
+            frame_shown = uploader.displayed_frame >= latency_frame;
+            if (frame_shown) latency_frame = 0;
         }
+        else
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+                buffer.width, buffer.height,
+                GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
+                buffer.data.data()
+            );
+        }
+        if (measure_latency && frame_shown) latency_stage(&latency, LATENCY_UPLOAD);
 
-        for (size_t bi = 0; bi < game.num_bullets; ++bi)
+        if (framebuffer_resized)
         {
-            const auto& bullet = game.bullets[bi];
-            const auto& sprite = bullet_sprite;
-            buffer_draw_sprite(&buffer, sprite, bullet.x, bullet.y, rgb_to_uint32(128, 0, 0));
+            viewport = viewport_fit(int(buffer.width), int(buffer.height), framebuffer_width, framebuffer_height);
+            glViewport(viewport.x, viewport.y, viewport.width, viewport.height);
+            framebuffer_resized = false;
         }
 
-        buffer_draw_sprite(&buffer, player_sprite, game.player.x, game.player.y,
-            rgb_to_uint32(128, 0, 0));
+        // The letterbox bars, glClear ignores the viewport
+        glClear(GL_COLOR_BUFFER_BIT);
 
-        
-        // Update animations
-        for (auto& animation : alien_animation)
+        if (blit)
         {
-            animation.time += 1;
-            if (animation.time == animation.num_frames * animation.frame_duration)
-            {
-                animation.time = 0;
-            }
+            glBlitFramebuffer(0, 0, int(buffer.width), int(buffer.height),
+                viewport.x, viewport.y, viewport.x + viewport.width, viewport.y + viewport.height,
+                GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        }
+        else
+        {
+            glDrawArrays(GL_TRIANGLES, 0, 3);
         }
 
-        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
-            buffer.width, buffer.height,
-            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
-            buffer.data.data()
-        );
+        if (async_upload) uploader_release(&uploader);
+        if (measure_latency && frame_shown) latency_gpu_mark(&latency);
 
-        glDrawArrays(GL_TRIANGLES, 0, 3);
-        
         glfwSwapBuffers(window);
-        // Simulate aliens
-        for (size_t ai = 0; ai < game.num_aliens; ++ai)
+
+        if (measure_latency)
+        {
+            if (frame_shown) latency_stage(&latency, LATENCY_SWAP);
+            latency_poll(&latency);
+        }
+
+        GameInput input;
+        input.move_dir = move_dir;
+        input.fire = fire_pressed;
+
+        if (attract)
         {
-            const auto& alien = game.aliens[ai];
-            if (alien.type == ALIEN_DEAD && death_counters[ai])
+            if (game_is_over(game))
             {
-                --death_counters[ai];
+                seed = glfwGetTimerValue();
+                game_init(&game, assets, game_config, seed);
+                if (replay_path) replay_begin_game(&replay, seed);
+                ++game_id;
             }
+
+            input = bot_next_input(&bot, game);
         }
-        // Simulate bullets
-        for (size_t bi = 0; bi < game.num_bullets;)
+
+        game_step(&game, assets, input, &events);
+        if (measure_latency && input_time && !attract)
         {
-            game.bullets[bi].y += game.bullets[bi].dir;
+            latency_tick(&latency, input_time);
+            latency_frame = 0;
+        }
+        input_time = 0;
+        event_bus_publish(&event_bus, events);
 
-            if (game.bullets[bi].y >= game.height ||
-                game.bullets[bi].y < bullet_sprite.height)
-            {
-                // Could be pop?
-                game.bullets[bi] = game.bullets[game.num_bullets - 1];
-                --game.num_bullets;
-                continue;
-            }
+        // The UFO script is the only other thing that changes the game
+        Ufo ufo = game.ufo;
+        behavior_tick(&behaviors);
+        if (replay_path) replay_record(&replay, replay_encode(input, ufo, game.ufo));
 
-            // Check hit
-            for (auto& alien : game.aliens)
-            {
-                if (alien.type == ALIEN_DEAD) continue;
-
-                auto& animation = alien_animation[alien.type - 1];
-                size_t current_frame = animation.time / animation.frame_duration;
-                const auto& alien_sprite = animation.frames[current_frame];
-                bool overlap = sprite_overlap_check(bullet_sprite, game.bullets[bi].x, game.bullets[bi].y,
-                    alien_sprite, alien.x, alien.y);
-
-                if (overlap)
-                {
-                    score += 10 * (AlienType::N - alien.type);
-                    alien.type = ALIEN_DEAD;
-                    // NOTE: Hack to recenter death sprite
-                    alien.x -=  (alien_death_sprite.width - alien_sprite.width) / 2;
-                    game.bullets[bi] = game.bullets[game.num_bullets - 1];
-                    --game.num_bullets;
-                    continue;
-                }
-            }
+        while (event_bus_poll(&event_bus, particle_events, &event_batch))
+        {
+            particles_emit_events(&particles, assets, event_batch);
+        }
+        particles_update(&particles, &jobs);
 
-            ++bi;
+        while (event_bus_poll(&event_bus, effect_events, &event_batch))
+        {
+            effects_emit_events(&effects, event_batch);
         }
-        // Simulate player
-        if (int player_move_dir = 2 * move_dir;
-            player_move_dir != 0)
+        effects_update(&effects, &jobs);
+
+        if (audio_enabled)
         {
-            if (game.player.x + player_sprite.width + player_move_dir >= game.width)
-            {
-                game.player.x = game.width - player_sprite.width;
-            }
-            else if ((int) game.player.x + player_move_dir <= 0)
-            {
-                game.player.x = 0;
-            }
-            else
+            while (event_bus_poll(&event_bus, audio_events, &event_batch))
             {
-                game.player.x += player_move_dir;
+                audio_emit_events(&audio, event_batch);
             }
+            audio_game_sounds(&audio, game);
+            audio_end_tick(&audio);
         }
 
-        // Player's fire
-        if (fire_pressed && game.num_bullets < GAME_MAX_BULLETS)
-        {
-            game.bullets[game.num_bullets].x = game.player.x + player_sprite.width / 2;
-            game.bullets[game.num_bullets].y = game.player.y + player_sprite.height;
-            game.bullets[game.num_bullets].dir = 2;
-            ++game.num_bullets;
-        }
+        if (telemetry_path) telemetry_record(&telemetry, game_id, game, events);
 
         fire_pressed = false;
 
         glfwPollEvents();
     }
 
+    if (replay_path && !replay_close(&replay))
+    {
+        std::println("Error writing replay {}", replay_path);
+    }
+
+    if (telemetry_path && !telemetry_close(&telemetry))
+    {
+        std::println("Error writing telemetry log {}", telemetry_path);
+    }
+
+    if (attract)
+    {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+        std::println("Bot: {:.0f} rollouts/s, {:.0f} simulated ticks/s on {} threads",
+            bot.num_rollouts / elapsed.count(), bot.num_ticks / elapsed.count(),
+            jobs_num_workers(jobs));
+    }
+
+    if (audio_enabled) audio_shutdown(&audio);
+    if (audio_path)
+    {
+        std::println("Audio: {} blocks mixed, {:.2f} us per block",
+            audio.blocks_mixed, audio.mix_nanoseconds / 1000.0 / std::max<uint64_t>(audio.blocks_mixed, 1));
+    }
+
+    behavior_shutdown(&behaviors);
+    effects_shutdown(&effects);
+    jobs_shutdown(&jobs);
+
+    if (async_upload)
+    {
+        uploader_shutdown(&uploader);
+        std::println("Upload: {} frames uploaded, {} skipped", uploader.frames_uploaded, uploader.frames_skipped);
+    }
+    if (measure_latency)
+    {
+        latency_report(latency);
+        latency_shutdown(&latency);
+    }
+    if (buffer_fbo) glDeleteFramebuffers(1, &buffer_fbo);
+
     glfwDestroyWindow(window);
     glfwTerminate();
     glDeleteVertexArrays(1, &fullscreen_triangle_vao);
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,209 @@
+#include "particles.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Multiple of the SIMD width, large enough to amortize handing out a chunk
+constexpr size_t PARTICLE_CHUNK = 16384;
+constexpr float PARTICLE_GRAVITY = 0.02f;
+
+static uint32_t particles_random(Particles* particles)
+{
+    uint64_t x = particles->rng_state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    particles->rng_state = x;
+    return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+// Uniform in [0, 1)
+static float particles_random_float(Particles* particles)
+{
+    return (particles_random(particles) >> 8) * (1.0f / 16777216.0f);
+}
+
+void particles_init(Particles* particles, size_t capacity, uint64_t seed)
+{
+    particles->count = 0;
+    particles->capacity = capacity;
+    particles->rng_state = (seed ^ 0x9e3779b97f4a7c15ull) | 1;
+    particles->x = std::vector<float>(capacity);
+    particles->y = std::vector<float>(capacity);
+    particles->vx = std::vector<float>(capacity);
+    particles->vy = std::vector<float>(capacity);
+    particles->life = std::vector<float>(capacity);
+    particles->color = std::vector<uint32_t>(capacity);
+    particles->chunk_counts = std::vector<size_t>((capacity + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK);
+}
+
+void particles_emit(Particles* particles, float x, float y, size_t count,
+    float speed, float life, uint32_t color)
+{
+    count = std::min(count, particles->capacity - particles->count);
+
+    for (size_t i = particles->count; i < particles->count + count; ++i)
+    {
+        float angle = 6.2831853f * particles_random_float(particles);
+        float v = speed * (0.25f + 0.75f * particles_random_float(particles));
+
+        particles->x[i] = x;
+        particles->y[i] = y;
+        particles->vx[i] = v * std::cos(angle);
+        particles->vy[i] = v * std::sin(angle);
+        particles->life[i] = life * (0.5f + 0.5f * particles_random_float(particles));
+        particles->color[i] = color;
+    }
+
+    particles->count += count;
+}
+
+void particles_emit_events(Particles* particles, const GameAssets& assets, const GameEvents& events)
+{
+    constexpr auto debris_color = rgb_to_uint32(255, 96, 0);
+    constexpr auto flash_color = rgb_to_uint32(255, 224, 128);
+
+    const auto& death_sprite = assets.alien_death_sprite;
+    const auto& bullet_sprite = assets.bullet_sprite;
+
+    for (size_t i = 0; i < events.num_events; ++i)
+    {
+        const auto& event = events.events[i];
+
+        if (event.type == EVENT_ALIEN_KILLED)
+        {
+            particles_emit(particles, event.x + 0.5f * death_sprite.width,
+                event.y + 0.5f * death_sprite.height, 48, 1.5f, 40.0f, debris_color);
+        }
+        else if (event.type == EVENT_SHOT_FIRED)
+        {
+            particles_emit(particles, event.x + 0.5f * bullet_sprite.width,
+                event.y + bullet_sprite.height, 8, 0.75f, 6.0f, flash_color);
+        }
+        else if (event.type == EVENT_SHOTS_COLLIDED)
+        {
+            particles_emit(particles, event.x + 0.5f * bullet_sprite.width,
+                event.y + bullet_sprite.height, 16, 1.0f, 12.0f, debris_color);
+        }
+    }
+}
+
+// Moves the particles in [begin, end) and swap-removes the dead ones within the
+// range. Returns the number of live particles, which are left at the front.
+static size_t particles_update_range(Particles* particles, size_t begin, size_t end)
+{
+    float* x = particles->x.data();
+    float* y = particles->y.data();
+    float* vx = particles->vx.data();
+    float* vy = particles->vy.data();
+    float* life = particles->life.data();
+
+    size_t i = begin;
+
+#if defined(__SSE2__)
+    const __m128 gravity = _mm_set1_ps(PARTICLE_GRAVITY);
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 px = _mm_loadu_ps(x + i);
+        __m128 py = _mm_loadu_ps(y + i);
+        __m128 pvx = _mm_loadu_ps(vx + i);
+        __m128 pvy = _mm_loadu_ps(vy + i);
+        __m128 plife = _mm_loadu_ps(life + i);
+
+        _mm_storeu_ps(x + i, _mm_add_ps(px, pvx));
+        _mm_storeu_ps(y + i, _mm_add_ps(py, pvy));
+        _mm_storeu_ps(vy + i, _mm_sub_ps(pvy, gravity));
+        _mm_storeu_ps(life + i, _mm_sub_ps(plife, one));
+    }
+#endif
+
+    for (; i < end; ++i)
+    {
+        x[i] += vx[i];
+        y[i] += vy[i];
+        vy[i] -= PARTICLE_GRAVITY;
+        life[i] -= 1.0f;
+    }
+
+    uint32_t* color = particles->color.data();
+
+    size_t last = end;
+    for (i = begin; i < last;)
+    {
+        if (life[i] > 0.0f)
+        {
+            ++i;
+            continue;
+        }
+
+        --last;
+        x[i] = x[last];
+        y[i] = y[last];
+        vx[i] = vx[last];
+        vy[i] = vy[last];
+        life[i] = life[last];
+        color[i] = color[last];
+    }
+
+    return last - begin;
+}
+
+// Moves n particles from src to dst, dst is never after src
+static void particles_move(Particles* particles, size_t dst, size_t src, size_t n)
+{
+    auto move = [&](auto& array) {
+        std::copy(array.begin() + src, array.begin() + src + n, array.begin() + dst);
+    };
+
+    move(particles->x);
+    move(particles->y);
+    move(particles->vx);
+    move(particles->vy);
+    move(particles->life);
+    move(particles->color);
+}
+
+void particles_update(Particles* particles, JobSystem* jobs)
+{
+    size_t count = particles->count;
+
+    if (!jobs || count <= PARTICLE_CHUNK)
+    {
+        particles->count = particles_update_range(particles, 0, count);
+        return;
+    }
+
+    size_t num_chunks = (count + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK;
+    jobs_parallel_for(jobs, num_chunks, 1, [&](size_t begin, size_t end, size_t) {
+        for (size_t c = begin; c < end; ++c)
+        {
+            size_t first = c * PARTICLE_CHUNK;
+            size_t last = std::min(first + PARTICLE_CHUNK, count);
+            particles->chunk_counts[c] = particles_update_range(particles, first, last);
+        }
+    });
+
+    // Close the gaps the dead particles left at the end of each chunk
+    size_t packed = particles->chunk_counts[0];
+    for (size_t c = 1; c < num_chunks; ++c)
+    {
+        size_t first = c * PARTICLE_CHUNK;
+        size_t alive = particles->chunk_counts[c];
+        if (packed != first) particles_move(particles, packed, first, alive);
+        packed += alive;
+    }
+
+    particles->count = packed;
+}
+
+void particles_render(const Particles& particles, Buffer* buffer)
+{
+    buffer_draw_points(buffer, particles.x.data(), particles.y.data(),
+        particles.color.data(), particles.count);
+}
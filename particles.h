@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "assets.h"
+#include "buffer.h"
+#include "game.h"
+#include "jobs.h"
+
+// Cosmetic particles, e.g. explosion debris. They live outside of Game, so they
+// never affect the simulation, its hash or its snapshots.
+//
+// Every attribute is its own array (structure of arrays), so the update streams
+// through memory four particles per SIMD instruction. Dead particles are
+// removed by moving the last live particle into their slot, which keeps the
+// live ones packed at the front.
+struct Particles
+{
+    size_t count;
+    size_t capacity;
+    uint64_t rng_state;
+    // Positions and velocities in pixels and pixels per tick
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    // Ticks left to live
+    std::vector<float> life;
+    std::vector<uint32_t> color;
+    // Live particles left in each chunk after a parallel update
+    std::vector<size_t> chunk_counts;
+};
+
+// Particles beyond the capacity are dropped when emitted
+void particles_init(Particles* particles, size_t capacity, uint64_t seed);
+
+// Spawns count particles at (x, y) flying in random directions with speeds of
+// up to speed pixels per tick, living for up to life ticks
+void particles_emit(Particles* particles, float x, float y, size_t count,
+    float speed, float life, uint32_t color);
+
+// Debris for killed aliens and a muzzle flash for every shot
+void particles_emit_events(Particles* particles, const GameAssets& assets, const GameEvents& events);
+
+// Advances the particles by one tick. With a job system the array is split into
+// chunks which are updated in parallel and then packed together again.
+void particles_update(Particles* particles, JobSystem* jobs = nullptr);
+
+void particles_render(const Particles& particles, Buffer* buffer);
@@ -0,0 +1,35 @@
+#include "policy.h"
+
+static uint32_t policy_random(RandomPolicy* policy)
+{
+    uint64_t x = policy->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    policy->state = x;
+    return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+void random_policy_init(RandomPolicy* policy, uint64_t seed)
+{
+    policy->state = (seed ^ 0x5851f42d4c957f2dull) | 1;
+    policy->hold = 0;
+    policy->input.move_dir = 0;
+    policy->input.fire = false;
+}
+
+GameInput random_policy_next(RandomPolicy* policy)
+{
+    if (policy->hold == 0)
+    {
+        policy->input.move_dir = static_cast<int>(policy_random(policy) % 3) - 1;
+        policy->hold = 4 + policy_random(policy) % 28;
+    }
+
+    --policy->hold;
+
+    // Fire on roughly one tick out of 16
+    GameInput input = policy->input;
+    input.fire = policy_random(policy) % 16 == 0;
+    return input;
+}
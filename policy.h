@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "game.h"
+
+// A random player, used to drive headless games. It holds each move for a few
+// ticks so it covers the playfield instead of jittering in place.
+struct RandomPolicy
+{
+    uint64_t state;
+    size_t hold;
+    GameInput input;
+};
+
+void random_policy_init(RandomPolicy* policy, uint64_t seed);
+
+GameInput random_policy_next(RandomPolicy* policy);
@@ -0,0 +1,129 @@
+#include "replay.h"
+
+#include <cstring>
+#include <utility>
+
+constexpr uint32_t REPLAY_MAGIC = 0x50525649;  // "IVRP"
+constexpr uint32_t REPLAY_VERSION = 1;
+constexpr size_t REPLAY_HEADER_WORDS = 11;
+
+bool replay_open(ReplayWriter* writer, const char* path, const GameConfig& config)
+{
+    writer->file = fopen(path, "wb");
+    if (!writer->file) return false;
+
+    uint32_t header[REPLAY_HEADER_WORDS] = {
+        REPLAY_MAGIC,
+        REPLAY_VERSION,
+        uint32_t(config.width),
+        uint32_t(config.height),
+        uint32_t(config.columns),
+        uint32_t(config.rows),
+        uint32_t(config.max_bullets),
+        uint32_t(config.bullet_speed),
+        uint32_t(config.max_divers),
+        uint32_t(config.dive_interval),
+        uint32_t(config.pixel_collisions)
+    };
+    writer->failed = fwrite(header, sizeof(header), 1, writer->file) != 1;
+    return true;
+}
+
+bool replay_close(ReplayWriter* writer)
+{
+    bool failed = fclose(writer->file) != 0 || writer->failed;
+    writer->file = nullptr;
+    return !failed;
+}
+
+void replay_begin_game(ReplayWriter* writer, uint64_t seed)
+{
+    uint8_t record[1 + sizeof(seed)];
+    record[0] = REPLAY_NEW_GAME;
+    std::memcpy(record + 1, &seed, sizeof(seed));
+    if (fwrite(record, sizeof(record), 1, writer->file) != 1) writer->failed = true;
+}
+
+uint8_t replay_encode(const GameInput& input, const Ufo& before, const Ufo& after)
+{
+    uint8_t tick = 0;
+    if (input.move_dir < 0) tick |= REPLAY_LEFT;
+    if (input.move_dir > 0) tick |= REPLAY_RIGHT;
+    if (input.fire) tick |= REPLAY_FIRE;
+
+    // The script moves a flying UFO every tick, starting with the one it spawns.
+    // A UFO shot down during the step is already gone, moving it does nothing.
+    bool spawned = !before.active && after.active;
+    if (spawned) tick |= REPLAY_UFO_SPAWN | (after.dir > 0 ? REPLAY_UFO_RIGHT : 0);
+    if (spawned || before.active) tick |= REPLAY_UFO_MOVE;
+
+    return tick;
+}
+
+void replay_step(Game* game, const GameAssets& assets, uint8_t tick)
+{
+    GameInput input;
+    input.move_dir = ((tick & REPLAY_RIGHT) ? 1 : 0) - ((tick & REPLAY_LEFT) ? 1 : 0);
+    input.fire = (tick & REPLAY_FIRE) != 0;
+    game_step(game, assets, input);
+
+    if (tick & REPLAY_UFO_SPAWN) game_ufo_spawn(game, assets, (tick & REPLAY_UFO_RIGHT) ? 1 : -1);
+    if (tick & REPLAY_UFO_MOVE) game_ufo_move(game, assets);
+}
+
+bool replay_load(Replay* replay, const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (!file) return false;
+
+    std::vector<uint8_t> data;
+    uint8_t chunk[1 << 16];
+    size_t size;
+    while ((size = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + size);
+    }
+    fclose(file);
+
+    uint32_t header[REPLAY_HEADER_WORDS];
+    if (data.size() < sizeof(header)) return false;
+    std::memcpy(header, data.data(), sizeof(header));
+    if (header[0] != REPLAY_MAGIC || header[1] != REPLAY_VERSION) return false;
+
+    replay->config.width = header[2];
+    replay->config.height = header[3];
+    replay->config.columns = header[4];
+    replay->config.rows = header[5];
+    replay->config.max_bullets = header[6];
+    replay->config.bullet_speed = header[7];
+    replay->config.max_divers = header[8];
+    replay->config.dive_interval = header[9];
+    replay->config.pixel_collisions = header[10] != 0;
+
+    // The header holds a finished config, anything the clamps would change is
+    // corrupt and could not be played
+    GameConfig finished = replay->config;
+    game_config_finish(&finished);
+    if (finished != replay->config || header[10] > 1) return false;
+
+    replay->games.clear();
+    for (size_t i = sizeof(header); i < data.size(); ++i)
+    {
+        if (data[i] != REPLAY_NEW_GAME)
+        {
+            // Ticks before the first game
+            if (replay->games.empty()) return false;
+            replay->games.back().ticks.push_back(data[i]);
+            continue;
+        }
+
+        if (i + sizeof(uint64_t) >= data.size()) return false;
+
+        ReplayGame game;
+        std::memcpy(&game.seed, &data[i + 1], sizeof(uint64_t));
+        replay->games.push_back(std::move(game));
+        i += sizeof(uint64_t);
+    }
+
+    return !replay->games.empty();
+}
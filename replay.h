@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "assets.h"
+#include "game.h"
+
+// Recorded sessions, replayed exactly by stepping fresh games with the same
+// seeds and inputs.
+//
+// Apart from the input, the only thing from outside the simulation is the
+// front end's UFO script, so each tick also records whether it spawned or
+// moved the UFO. That makes a tick a single byte.
+//
+// File layout, all values little endian:
+//
+//   header:  u32 magic "IVRP", u32 version, u32 width, u32 height,
+//            u32 columns, u32 rows, u32 max_bullets, u32 bullet_speed,
+//            u32 max_divers, u32 dive_interval, u32 pixel_collisions
+//   body:    REPLAY_NEW_GAME followed by the u64 seed of the game, then one
+//            byte per tick, repeated for every game of the session
+
+constexpr uint8_t REPLAY_LEFT = 1;
+constexpr uint8_t REPLAY_RIGHT = 2;
+constexpr uint8_t REPLAY_FIRE = 4;
+// The UFO was spawned after game_step(), from the left edge if REPLAY_UFO_RIGHT
+constexpr uint8_t REPLAY_UFO_SPAWN = 8;
+constexpr uint8_t REPLAY_UFO_RIGHT = 16;
+// game_ufo_move() was called after game_step() and any spawn
+constexpr uint8_t REPLAY_UFO_MOVE = 32;
+constexpr uint8_t REPLAY_NEW_GAME = 128;
+
+struct ReplayWriter
+{
+    FILE* file;
+    bool failed;
+};
+
+struct ReplayGame
+{
+    uint64_t seed;
+    std::vector<uint8_t> ticks;
+};
+
+struct Replay
+{
+    GameConfig config;
+    std::vector<ReplayGame> games;
+};
+
+bool replay_open(ReplayWriter* writer, const char* path, const GameConfig& config);
+
+// Returns false if anything could not be written
+bool replay_close(ReplayWriter* writer);
+
+// Call after every game_init() of the recorded session
+void replay_begin_game(ReplayWriter* writer, uint64_t seed);
+
+inline void replay_record(ReplayWriter* writer, uint8_t tick)
+{
+    if (fputc(tick, writer->file) == EOF) writer->failed = true;
+}
+
+// The byte of a tick from its input and the UFO before and after the script ran
+uint8_t replay_encode(const GameInput& input, const Ufo& before, const Ufo& after);
+
+// Replays one tick recorded by replay_encode()
+void replay_step(Game* game, const GameAssets& assets, uint8_t tick);
+
+// Returns false if the file cannot be read or is not a valid replay, including
+// a config that game_config_finish() would change
+bool replay_load(Replay* replay, const char* path);
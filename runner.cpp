@@ -0,0 +1,374 @@
+// Runs large batches of headless games across several worker processes. Each
+// worker is pinned to its own CPU and writes its results straight into a
+// shared memory table, which the parent aggregates once all workers are done.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <format>
+#include <new>
+#include <print>
+#include <thread>
+#include <vector>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "assets.h"
+#include "buffer.h"
+#include "game.h"
+#include "policy.h"
+#include "telemetry.h"
+
+struct RunnerConfig
+{
+    size_t num_workers;
+    size_t num_games;
+    size_t max_ticks;
+    size_t hash_every;
+    uint64_t seed;
+    GameConfig game;
+    // Each worker writes its games to <telemetry>.<worker>.ivtl
+    const char* telemetry;
+    bool verbose;
+};
+
+struct RunnerResult
+{
+    uint64_t seed;
+    uint64_t score;
+    uint64_t ticks;
+    uint64_t frame_hash;
+};
+
+// Each worker only ever writes its own progress counter and its own range of
+// results, so nothing on the hot path needs a lock. The counters are padded to
+// a cache line each so workers do not invalidate each other's lines.
+struct alignas(64) RunnerProgress
+{
+    std::atomic<uint64_t> games_done;
+};
+
+struct RunnerTable
+{
+    RunnerProgress* progress;
+    RunnerResult* results;
+    void* memory;
+    size_t size;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+    "Progress counters are shared between processes and must be lock free");
+
+bool runner_table_create(RunnerTable* table, size_t num_workers, size_t num_games)
+{
+    table->size = num_workers * sizeof(RunnerProgress) + num_games * sizeof(RunnerResult);
+    table->memory = mmap(nullptr, table->size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+    if (table->memory == MAP_FAILED) return false;
+
+    table->progress = static_cast<RunnerProgress*>(table->memory);
+    table->results = reinterpret_cast<RunnerResult*>(table->progress + num_workers);
+
+    for (size_t i = 0; i < num_workers; ++i)
+    {
+        new (&table->progress[i]) RunnerProgress;
+        table->progress[i].games_done.store(0, std::memory_order_relaxed);
+    }
+
+    return true;
+}
+
+void runner_table_destroy(RunnerTable* table)
+{
+    munmap(table->memory, table->size);
+}
+
+// Worker w plays the contiguous range of games [begin, end), so each worker
+// fills its own block of rows in the results table.
+void runner_worker_range(const RunnerConfig& config, size_t worker, size_t* begin, size_t* end)
+{
+    *begin = worker * config.num_games / config.num_workers;
+    *end = (worker + 1) * config.num_games / config.num_workers;
+}
+
+void runner_pin(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (sched_setaffinity(0, sizeof(set), &set) != 0)
+    {
+        std::println("Warning: could not pin worker to CPU {}", cpu);
+    }
+}
+
+void runner_worker(const RunnerConfig& config, size_t worker, int cpu, RunnerTable* table)
+{
+    // Pin before touching any memory, so the kernel's first touch policy places
+    // the worker's pages on the NUMA node of its CPU.
+    if (cpu >= 0) runner_pin(cpu);
+
+    GameAssets assets;
+    assets_init(&assets);
+
+    Game game;
+    game_init(&game, assets, config.game, 0);
+
+    Buffer buffer;
+    buffer.width = game.width;
+    buffer.height = game.height;
+    buffer.data = std::vector<uint32_t>(buffer.width * buffer.height);
+
+    size_t begin, end;
+    runner_worker_range(config, worker, &begin, &end);
+
+    TelemetryLog telemetry;
+    GameEvents events;
+    bool record = config.telemetry != nullptr;
+    if (record)
+    {
+        auto path = std::format("{}.{}.ivtl", config.telemetry, worker);
+        if (!telemetry_open(&telemetry, path.c_str()))
+        {
+            std::println("Error opening {}: {}", path, std::strerror(errno));
+            record = false;
+        }
+    }
+
+    for (size_t gi = begin; gi < end; ++gi)
+    {
+        uint64_t seed = config.seed + gi;
+        game_init(&game, assets, config.game, seed);
+
+        RandomPolicy policy;
+        random_policy_init(&policy, seed);
+
+        uint64_t frame_hash = 0;
+        size_t tick = 0;
+        while (tick < config.max_ticks && !game_is_over(game))
+        {
+            if (record)
+            {
+                game_step(&game, assets, random_policy_next(&policy), &events);
+                telemetry_record(&telemetry, gi, game, events);
+            }
+            else
+            {
+                game_step(&game, assets, random_policy_next(&policy));
+            }
+            ++tick;
+
+            if (config.hash_every && tick % config.hash_every == 0)
+            {
+                game_render(game, assets, &buffer);
+                frame_hash = frame_hash * 0x100000001b3ull ^ buffer_hash(buffer);
+            }
+        }
+
+        // Always include the final frame
+        game_render(game, assets, &buffer);
+        frame_hash = frame_hash * 0x100000001b3ull ^ buffer_hash(buffer);
+
+        auto& result = table->results[gi];
+        result.seed = seed;
+        result.score = game.score;
+        result.ticks = tick;
+        result.frame_hash = frame_hash;
+
+        table->progress[worker].games_done.fetch_add(1, std::memory_order_release);
+    }
+
+    if (record && !telemetry_close(&telemetry))
+    {
+        std::println("Error writing the telemetry of worker {}", worker);
+    }
+}
+
+void print_usage()
+{
+    std::println("Usage: invaders_runner [options]");
+    std::println("  --workers K      number of worker processes, at least 1 (default: number of CPUs)");
+    std::println("  --games N        number of games to play, at least 1 (default: 1000)");
+    std::println("  --ticks T        maximum ticks per game (default: 10000)");
+    std::println("  --seed S         seed of the first game (default: 1)");
+    std::println("  --hash-every F   also hash every F-th frame, not just the last one");
+    std::println("  --telemetry P    record telemetry logs P.<worker>.ivtl");
+    std::println("  --no-pin         do not pin workers to CPUs");
+    std::println("  --verbose        print one line per game");
+    game_config_print_usage();
+}
+
+int main(int argc, char** argv)
+{
+    // CPUs we are allowed to run on, so that e.g. taskset is respected
+    cpu_set_t allowed;
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &allowed)) cpus.push_back(cpu);
+        }
+    }
+
+    RunnerConfig config;
+    config.num_workers = std::max<size_t>(cpus.empty() ? std::thread::hardware_concurrency() : cpus.size(), 1);
+    config.num_games = 1000;
+    config.max_ticks = 10000;
+    config.hash_every = 0;
+    config.seed = 1;
+    config.game = game_default_config();
+    config.telemetry = nullptr;
+    config.verbose = false;
+    bool pin = !cpus.empty();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        bool has_value = i + 1 < argc;
+
+        if (!std::strcmp(argv[i], "--workers") && has_value)
+            config.num_workers = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--games") && has_value)
+            config.num_games = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--ticks") && has_value)
+            config.max_ticks = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--seed") && has_value)
+            config.seed = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--hash-every") && has_value)
+            config.hash_every = std::strtoull(argv[++i], nullptr, 10);
+        else if (!std::strcmp(argv[i], "--telemetry") && has_value)
+            config.telemetry = argv[++i];
+        else if (!std::strcmp(argv[i], "--no-pin"))
+            pin = false;
+        else if (!std::strcmp(argv[i], "--verbose"))
+            config.verbose = true;
+        else if (game_config_parse_option(&config.game, argc, argv, &i))
+            continue;
+        else
+        {
+            print_usage();
+            return -1;
+        }
+    }
+
+    game_config_finish(&config.game);
+
+    if (config.num_workers == 0 || config.num_games == 0)
+    {
+        std::println("At least one worker and one game are needed.");
+        print_usage();
+        return -1;
+    }
+    if (config.num_workers > config.num_games) config.num_workers = config.num_games;
+
+    RunnerTable table;
+    if (!runner_table_create(&table, config.num_workers, config.num_games))
+    {
+        std::println("Error allocating the shared results table.");
+        return -1;
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    std::vector<pid_t> workers;
+    for (size_t w = 0; w < config.num_workers; ++w)
+    {
+        pid_t pid = fork();
+
+        if (pid < 0)
+        {
+            std::println("Error forking worker {}: {}", w, std::strerror(errno));
+            break;
+        }
+
+        if (pid == 0)
+        {
+            int cpu = pin ? cpus[w % cpus.size()] : -1;
+            runner_worker(config, w, cpu, &table);
+            std::fflush(stdout);
+            _exit(0);
+        }
+
+        workers.push_back(pid);
+    }
+
+    // Report progress while the workers are running
+    size_t games_done = 0;
+    while (true)
+    {
+        games_done = 0;
+        for (size_t w = 0; w < workers.size(); ++w)
+        {
+            games_done += table.progress[w].games_done.load(std::memory_order_acquire);
+        }
+
+        bool running = false;
+        for (auto pid : workers)
+        {
+            if (pid > 0 && waitpid(pid, nullptr, WNOHANG) == 0) running = true;
+        }
+
+        if (!running) break;
+
+        std::print("\r{}/{} games", games_done, config.num_games);
+        std::fflush(stdout);
+        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    }
+    std::println("\r{}/{} games", games_done, config.num_games);
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+
+    // Aggregate, only over the games that actually finished
+    size_t num_results = 0;
+    uint64_t total_score = 0, total_ticks = 0, combined_hash = 0;
+    uint64_t min_score = UINT64_MAX, max_score = 0;
+    for (size_t w = 0; w < workers.size(); ++w)
+    {
+        size_t begin, end;
+        runner_worker_range(config, w, &begin, &end);
+        end = begin + table.progress[w].games_done.load(std::memory_order_acquire);
+
+        for (size_t gi = begin; gi < end; ++gi)
+        {
+            const auto& result = table.results[gi];
+            if (config.verbose)
+            {
+                std::println("seed {} score {} ticks {} hash {:016x}",
+                    result.seed, result.score, result.ticks, result.frame_hash);
+            }
+
+            total_score += result.score;
+            total_ticks += result.ticks;
+            min_score = std::min(min_score, result.score);
+            max_score = std::max(max_score, result.score);
+            combined_hash ^= result.frame_hash;
+            ++num_results;
+        }
+    }
+
+    runner_table_destroy(&table);
+
+    if (num_results == 0)
+    {
+        std::println("No games finished.");
+        return -1;
+    }
+
+    std::println("workers:      {}", workers.size());
+    std::println("games:        {}", num_results);
+    std::println("score:        mean {:.1f}, min {}, max {}",
+        double(total_score) / num_results, min_score, max_score);
+    std::println("ticks:        mean {:.1f}, total {}", double(total_ticks) / num_results, total_ticks);
+    std::println("elapsed:      {:.3f} s, {:.0f} ticks/s", elapsed.count(), total_ticks / elapsed.count());
+    std::println("results hash: {:016x}", combined_hash);
+
+    return num_results == config.num_games ? 0 : -1;
+}
@@ -0,0 +1,32 @@
+#include "scripts.h"
+
+// xorshift64*, like game_random(), but with its own state so the scripts do
+// not change the game's random sequence
+static uint32_t script_random(uint64_t* state)
+{
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return (x * 0x2545f4914f6cdd1dull) >> 32;
+}
+
+Behavior ufo_flyovers(Game* game, const GameAssets* assets, uint64_t seed)
+{
+    uint64_t state = (seed ^ 0xd1b54a32d192ed03ull) | 1;
+
+    while (true)
+    {
+        co_await behavior_wait(600 + script_random(&state) % 900);
+        if (game_is_over(*game)) continue;
+
+        game_ufo_spawn(game, *assets, script_random(&state) % 2 ? 1 : -1);
+
+        // Until it leaves the screen or is shot down
+        while (game_ufo_move(game, *assets))
+        {
+            co_await behavior_next_tick();
+        }
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+#include "assets.h"
+#include "behavior.h"
+#include "game.h"
+
+// Enemy behaviors scripted as coroutines, run by a BehaviorScheduler once per
+// game tick. They drive the game through its public functions, so the Game
+// itself stays a plain value that can be copied and snapshotted.
+
+// Sends the UFO across the screen every 10 to 25 seconds, forever
+Behavior ufo_flyovers(Game* game, const GameAssets* assets, uint64_t seed);
@@ -0,0 +1,140 @@
+#include "spline.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <xmmintrin.h>
+#endif
+
+// Samples per segment when measuring the arc length
+constexpr size_t SPLINE_LENGTH_SAMPLES = 32;
+
+static void spline_point(const float* coefficients, float t, float* x, float* y)
+{
+    const float* c = coefficients;
+    *x = ((c[0] * t + c[1]) * t + c[2]) * t + c[3];
+    *y = ((c[4] * t + c[5]) * t + c[6]) * t + c[7];
+}
+
+size_t spline_add_catmull_rom(SplineSet* splines, const float* points, size_t num_points)
+{
+    size_t path = splines->lengths.size();
+    size_t first_segment = splines->coefficients.size() / 8;
+    size_t num_segments = num_points - 3;
+
+    for (size_t s = 0; s < num_segments; ++s)
+    {
+        for (size_t axis = 0; axis < 2; ++axis)
+        {
+            float p0 = points[2 * s + axis];
+            float p1 = points[2 * (s + 1) + axis];
+            float p2 = points[2 * (s + 2) + axis];
+            float p3 = points[2 * (s + 3) + axis];
+
+            splines->coefficients.push_back(0.5f * (-p0 + 3 * p1 - 3 * p2 + p3));
+            splines->coefficients.push_back(0.5f * (2 * p0 - 5 * p1 + 4 * p2 - p3));
+            splines->coefficients.push_back(0.5f * (-p0 + p2));
+            splines->coefficients.push_back(p1);
+        }
+    }
+
+    // Measure the path with short chords, then invert distance(parameter)
+    size_t num_samples = num_segments * SPLINE_LENGTH_SAMPLES;
+    std::vector<float> sample_lengths(num_samples + 1, 0.0f);
+
+    float px, py;
+    spline_point(&splines->coefficients[first_segment * 8], 0.0f, &px, &py);
+    for (size_t i = 1; i <= num_samples; ++i)
+    {
+        size_t segment = std::min((i - 1) / SPLINE_LENGTH_SAMPLES, num_segments - 1);
+        float t = float(i - segment * SPLINE_LENGTH_SAMPLES) / SPLINE_LENGTH_SAMPLES;
+
+        float x, y;
+        spline_point(&splines->coefficients[(first_segment + segment) * 8], t, &x, &y);
+        sample_lengths[i] = sample_lengths[i - 1] + std::sqrt((x - px) * (x - px) + (y - py) * (y - py));
+        px = x;
+        py = y;
+    }
+
+    float length = sample_lengths[num_samples];
+    size_t sample = 0;
+    for (size_t k = 0; k <= SPLINE_LUT_SIZE; ++k)
+    {
+        float distance = length * k / SPLINE_LUT_SIZE;
+        while (sample + 1 < num_samples && sample_lengths[sample + 1] < distance) ++sample;
+
+        float span = sample_lengths[sample + 1] - sample_lengths[sample];
+        float f = span > 0 ? std::clamp((distance - sample_lengths[sample]) / span, 0.0f, 1.0f) : 0.0f;
+        splines->parameters.push_back((sample + f) / SPLINE_LENGTH_SAMPLES);
+    }
+
+    splines->first_segment.push_back(first_segment);
+    splines->num_segments.push_back(num_segments);
+    splines->lengths.push_back(length);
+    splines->lut_scales.push_back(length > 0 ? SPLINE_LUT_SIZE / length : 0.0f);
+    return path;
+}
+
+// Segment and local parameter at a distance along a path, from the table
+static void spline_lookup(const SplineSet& splines, uint16_t path, float distance,
+    uint32_t* segment, float* t)
+{
+    float f = std::clamp(distance * splines.lut_scales[path], 0.0f, float(SPLINE_LUT_SIZE));
+    size_t k = std::min(size_t(f), SPLINE_LUT_SIZE - 1);
+
+    const float* parameters = &splines.parameters[path * (SPLINE_LUT_SIZE + 1)];
+    float u = parameters[k] + (parameters[k + 1] - parameters[k]) * (f - k);
+
+    // The end of the last segment, not the start of the one after it
+    size_t local = std::min<size_t>(u, splines.num_segments[path] - 1);
+
+    *segment = splines.first_segment[path] + local;
+    *t = u - local;
+}
+
+void spline_evaluate(const SplineSet& splines, const uint16_t* paths, const float* distances,
+    float* x, float* y, size_t count)
+{
+    const float* coefficients = splines.coefficients.data();
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    // Four points at a time: load each lane's coefficients and transpose them,
+    // so every register holds the same coefficient of four segments
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t segments[4];
+        alignas(16) float t[4];
+        for (size_t lane = 0; lane < 4; ++lane)
+        {
+            spline_lookup(splines, paths[i + lane], distances[i + lane], &segments[lane], &t[lane]);
+        }
+
+        const float* c0 = coefficients + segments[0] * 8;
+        const float* c1 = coefficients + segments[1] * 8;
+        const float* c2 = coefficients + segments[2] * 8;
+        const float* c3 = coefficients + segments[3] * 8;
+
+        __m128 ax = _mm_loadu_ps(c0), bx = _mm_loadu_ps(c1), cx = _mm_loadu_ps(c2), dx = _mm_loadu_ps(c3);
+        __m128 ay = _mm_loadu_ps(c0 + 4), by = _mm_loadu_ps(c1 + 4), cy = _mm_loadu_ps(c2 + 4), dy = _mm_loadu_ps(c3 + 4);
+        _MM_TRANSPOSE4_PS(ax, bx, cx, dx);
+        _MM_TRANSPOSE4_PS(ay, by, cy, dy);
+
+        __m128 tv = _mm_load_ps(t);
+        __m128 px = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ax, tv), bx), tv), cx), tv), dx);
+        __m128 py = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ay, tv), by), tv), cy), tv), dy);
+
+        _mm_storeu_ps(x + i, px);
+        _mm_storeu_ps(y + i, py);
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        uint32_t segment;
+        float t;
+        spline_lookup(splines, paths[i], distances[i], &segment, &t);
+        spline_point(coefficients + segment * 8, t, &x[i], &y[i]);
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Catmull-Rom paths, evaluated by arc length.
+//
+// Every segment is converted to the coefficients of a cubic polynomial once,
+// p(t) = ((a t + b) t + c) t + d for x and y, so evaluating a point is a few
+// multiply-adds. Moving at a constant speed needs the parameter t at a given
+// distance along the path. That is looked up in a table of parameters at evenly
+// spaced distances, built once when the path is added, so no square roots or
+// integration are needed after that.
+
+constexpr size_t SPLINE_LUT_SIZE = 256;
+
+struct SplineSet
+{
+    // ax, bx, cx, dx, ay, by, cy, dy of every segment of every path
+    std::vector<float> coefficients;
+    // Per path
+    std::vector<uint32_t> first_segment;
+    std::vector<uint32_t> num_segments;
+    std::vector<float> lengths;
+    // Table entries per pixel of length
+    std::vector<float> lut_scales;
+    // SPLINE_LUT_SIZE + 1 parameters per path, the integer part of a parameter
+    // is the segment within the path
+    std::vector<float> parameters;
+};
+
+// Adds the path through points[1] ... points[num_points - 2], the first and last
+// point only shape the ends. points holds x, y pairs. Returns the path's index.
+size_t spline_add_catmull_rom(SplineSet* splines, const float* points, size_t num_points);
+
+// Positions at the given distances along the given paths, distances are
+// clamped to the path's length
+void spline_evaluate(const SplineSet& splines, const uint16_t* paths, const float* distances,
+    float* x, float* y, size_t count);
@@ -0,0 +1,331 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+constexpr uint32_t TELEMETRY_MAGIC = 0x4c545649;  // "IVTL"
+constexpr uint32_t TELEMETRY_BLOCK_MAGIC = 0x42545649;  // "IVTB"
+constexpr uint32_t TELEMETRY_VERSION = 1;
+constexpr size_t TELEMETRY_HEADER_SIZE = 2 * sizeof(uint32_t);
+constexpr size_t TELEMETRY_BLOCK_HEADER_SIZE = 4 * sizeof(uint32_t);
+// Two blocks per stream, so the game thread can fill one while the other is written
+constexpr size_t TELEMETRY_NUM_BLOCKS = 2 * TELEMETRY_NUM_STREAMS;
+constexpr size_t TELEMETRY_INITIAL_CAPACITY = 16 << 20;
+
+static const size_t telemetry_num_columns[TELEMETRY_NUM_STREAMS] = {
+    EVENT_NUM_COLUMNS, TICK_NUM_COLUMNS
+};
+
+static bool telemetry_reserve(TelemetryLog* log, size_t size)
+{
+    if (size <= log->capacity) return true;
+
+    size_t capacity = log->capacity;
+    while (capacity < size) capacity *= 2;
+
+    if (ftruncate(log->fd, capacity) != 0) return false;
+
+    void* data = mremap(log->data, log->capacity, capacity, MREMAP_MAYMOVE);
+    if (data == MAP_FAILED) return false;
+
+    log->data = static_cast<uint8_t*>(data);
+    log->capacity = capacity;
+    return true;
+}
+
+static uint8_t* encode_varint(uint8_t* out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        *out++ = uint8_t(value) | 0x80;
+        value >>= 7;
+    }
+    *out++ = uint8_t(value);
+    return out;
+}
+
+// Appends an encoded block, only called by the writer thread
+static bool telemetry_write_block(TelemetryLog* log, const TelemetryBlock& block)
+{
+    size_t num_columns = telemetry_num_columns[block.stream];
+
+    // Worst case of 10 bytes per value
+    size_t max_size = TELEMETRY_BLOCK_HEADER_SIZE +
+        num_columns * (sizeof(uint32_t) + 10 * block.num_rows);
+    if (!telemetry_reserve(log, log->size + max_size)) return false;
+
+    uint8_t* begin = log->data + log->size;
+    uint8_t* out = begin + TELEMETRY_BLOCK_HEADER_SIZE;
+
+    for (size_t c = 0; c < num_columns; ++c)
+    {
+        uint8_t* column_begin = out + sizeof(uint32_t);
+        uint8_t* column_end = column_begin;
+
+        int64_t previous = 0;
+        for (size_t row = 0; row < block.num_rows; ++row)
+        {
+            int64_t value = block.columns[c][row];
+            int64_t delta = value - previous;
+            previous = value;
+            uint64_t zigzag = (uint64_t(delta) << 1) ^ uint64_t(delta >> 63);
+            column_end = encode_varint(column_end, zigzag);
+        }
+
+        uint32_t column_size = column_end - column_begin;
+        std::memcpy(out, &column_size, sizeof(column_size));
+        out = column_end;
+    }
+
+    uint32_t header[4] = {
+        TELEMETRY_BLOCK_MAGIC,
+        uint32_t(block.stream) | uint32_t(num_columns) << 8,
+        uint32_t(block.num_rows),
+        uint32_t(out - begin - TELEMETRY_BLOCK_HEADER_SIZE)
+    };
+    std::memcpy(begin, header, sizeof(header));
+
+    log->size = out - log->data;
+    return true;
+}
+
+static void telemetry_writer(TelemetryLog* log)
+{
+    std::vector<TelemetryBlock*> blocks;
+    blocks.reserve(TELEMETRY_NUM_BLOCKS);
+
+    while (true)
+    {
+        {
+            std::unique_lock lock(log->mutex);
+            log->changed.wait(lock, [&] { return log->quit || !log->full_blocks.empty(); });
+            if (log->full_blocks.empty()) return;
+            blocks.swap(log->full_blocks);
+        }
+
+        bool ok = true;
+        for (auto block : blocks)
+        {
+            ok = telemetry_write_block(log, *block) && ok;
+        }
+
+        {
+            std::lock_guard lock(log->mutex);
+            if (!ok) log->failed = true;
+            for (auto block : blocks)
+            {
+                log->free_blocks.push_back(block);
+            }
+        }
+        log->changed.notify_all();
+        blocks.clear();
+    }
+}
+
+bool telemetry_open(TelemetryLog* log, const char* path)
+{
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (log->fd < 0) return false;
+
+    if (ftruncate(log->fd, TELEMETRY_INITIAL_CAPACITY) != 0)
+    {
+        close(log->fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, TELEMETRY_INITIAL_CAPACITY, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (data == MAP_FAILED)
+    {
+        close(log->fd);
+        return false;
+    }
+
+    log->data = static_cast<uint8_t*>(data);
+    log->capacity = TELEMETRY_INITIAL_CAPACITY;
+
+    uint32_t header[2] = { TELEMETRY_MAGIC, TELEMETRY_VERSION };
+    std::memcpy(log->data, header, sizeof(header));
+    log->size = TELEMETRY_HEADER_SIZE;
+
+    log->blocks = std::make_unique<TelemetryBlock[]>(TELEMETRY_NUM_BLOCKS);
+    log->free_blocks.clear();
+    log->full_blocks.clear();
+    log->free_blocks.reserve(TELEMETRY_NUM_BLOCKS);
+    log->full_blocks.reserve(TELEMETRY_NUM_BLOCKS);
+
+    for (size_t i = 0; i < TELEMETRY_NUM_BLOCKS; ++i)
+    {
+        log->free_blocks.push_back(&log->blocks[i]);
+    }
+
+    for (size_t stream = 0; stream < TELEMETRY_NUM_STREAMS; ++stream)
+    {
+        log->current[stream] = log->free_blocks.back();
+        log->free_blocks.pop_back();
+        log->current[stream]->stream = static_cast<TelemetryStream>(stream);
+        log->current[stream]->num_rows = 0;
+    }
+
+    log->quit = false;
+    log->failed = false;
+    log->writer = std::thread(telemetry_writer, log);
+
+    return true;
+}
+
+void telemetry_submit(TelemetryLog* log, TelemetryStream stream)
+{
+    auto block = log->current[stream];
+
+    std::unique_lock lock(log->mutex);
+    log->full_blocks.push_back(block);
+    log->changed.notify_all();
+
+    // Only blocks if the writer has fallen a whole block behind
+    log->changed.wait(lock, [&] { return !log->free_blocks.empty(); });
+    block = log->free_blocks.back();
+    log->free_blocks.pop_back();
+    lock.unlock();
+
+    block->stream = stream;
+    block->num_rows = 0;
+    log->current[stream] = block;
+}
+
+bool telemetry_close(TelemetryLog* log)
+{
+    {
+        std::lock_guard lock(log->mutex);
+        for (auto block : log->current)
+        {
+            if (block->num_rows > 0) log->full_blocks.push_back(block);
+        }
+        log->quit = true;
+    }
+    log->changed.notify_all();
+    log->writer.join();
+
+    bool ok = !log->failed;
+    munmap(log->data, log->capacity);
+    ok = ftruncate(log->fd, log->size) == 0 && ok;
+    ok = close(log->fd) == 0 && ok;
+
+    log->blocks.reset();
+    return ok;
+}
+
+void telemetry_record(TelemetryLog* log, uint64_t game_id, const Game& game, const GameEvents& events)
+{
+    for (size_t i = 0; i < events.num_events; ++i)
+    {
+        telemetry_event(log, game_id, game.tick, events.events[i]);
+    }
+
+    auto block = log->current[TELEMETRY_TICKS];
+    size_t row = block->num_rows++;
+    block->columns[TICK_COLUMN_GAME][row] = game_id;
+    block->columns[TICK_COLUMN_TICK][row] = game.tick;
+    block->columns[TICK_COLUMN_SCORE][row] = game.score;
+    block->columns[TICK_COLUMN_LIVES][row] = game.player.life;
+    block->columns[TICK_COLUMN_ALIENS][row] = game.num_alive;
+    block->columns[TICK_COLUMN_BULLETS][row] = game.num_bullets;
+    block->columns[TICK_COLUMN_PLAYER_X][row] = game.player.x;
+
+    if (block->num_rows == TELEMETRY_BLOCK_ROWS) telemetry_submit(log, TELEMETRY_TICKS);
+}
+
+const uint8_t* telemetry_first_block(const uint8_t* data, size_t size)
+{
+    if (size < TELEMETRY_HEADER_SIZE) return nullptr;
+
+    uint32_t header[2];
+    std::memcpy(header, data, sizeof(header));
+    if (header[0] != TELEMETRY_MAGIC || header[1] != TELEMETRY_VERSION) return nullptr;
+
+    return data + TELEMETRY_HEADER_SIZE;
+}
+
+const uint8_t* telemetry_read_block(const uint8_t* data, const uint8_t* end, TelemetryBlockView* view)
+{
+    if (end - data < ptrdiff_t(TELEMETRY_BLOCK_HEADER_SIZE)) return nullptr;
+
+    uint32_t header[4];
+    std::memcpy(header, data, sizeof(header));
+    if (header[0] != TELEMETRY_BLOCK_MAGIC) return nullptr;
+
+    view->stream = static_cast<TelemetryStream>(header[1] & 0xff);
+    view->num_columns = (header[1] >> 8) & 0xff;
+    view->num_rows = header[2];
+
+    // The sizes come from the file, they are checked against the bytes left
+    // before any pointer is moved by them
+    const uint8_t* payload = data + TELEMETRY_BLOCK_HEADER_SIZE;
+    if (view->stream >= TELEMETRY_NUM_STREAMS || view->num_columns > TELEMETRY_MAX_COLUMNS ||
+        header[3] > size_t(end - payload))
+    {
+        return nullptr;
+    }
+    const uint8_t* payload_end = payload + header[3];
+
+    for (size_t c = 0; c < view->num_columns; ++c)
+    {
+        uint32_t size;
+        if (size_t(payload_end - payload) < sizeof(size)) return nullptr;
+        std::memcpy(&size, payload, sizeof(size));
+        payload += sizeof(size);
+
+        if (size > size_t(payload_end - payload)) return nullptr;
+        view->columns[c] = payload;
+        view->column_sizes[c] = size;
+        payload += size;
+    }
+
+    return payload_end;
+}
+
+bool telemetry_is_partial_block(const uint8_t* data, const uint8_t* end)
+{
+    if (end - data < ptrdiff_t(TELEMETRY_BLOCK_HEADER_SIZE)) return true;
+
+    uint32_t header[4];
+    std::memcpy(header, data, sizeof(header));
+    if (header[0] == TELEMETRY_BLOCK_MAGIC)
+    {
+        return (header[1] & 0xff) < TELEMETRY_NUM_STREAMS &&
+            ((header[1] >> 8) & 0xff) <= TELEMETRY_MAX_COLUMNS &&
+            header[3] > size_t(end - data) - TELEMETRY_BLOCK_HEADER_SIZE;
+    }
+
+    return std::all_of(data, end, [](uint8_t byte) { return byte == 0; });
+}
+
+bool telemetry_decode_column(const TelemetryBlockView& view, size_t column, int64_t* values)
+{
+    if (column >= view.num_columns) return false;
+
+    const uint8_t* in = view.columns[column];
+    const uint8_t* end = in + view.column_sizes[column];
+
+    int64_t previous = 0;
+    for (size_t row = 0; row < view.num_rows; ++row)
+    {
+        uint64_t zigzag = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            if (in == end || shift > 63) return false;
+
+            uint8_t byte = *in++;
+            zigzag |= uint64_t(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) break;
+        }
+
+        int64_t delta = int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1);
+        previous += delta;
+        values[row] = previous;
+    }
+
+    return true;
+}
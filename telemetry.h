@@ -0,0 +1,143 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+
+// Append-only binary log of game events and per-tick statistics.
+//
+// Rows are appended to an uncompressed block in memory, which only costs a few
+// stores on the game thread. Full blocks are handed to a writer thread which
+// compresses every column on its own (delta to the previous row, zigzag, LEB128
+// varint) and appends the result to a memory mapped file.
+//
+// File layout, all values little endian:
+//
+//   header:  u32 magic "IVTL", u32 version
+//   blocks:  u32 magic "IVTB", u8 stream, u8 num_columns, u16 reserved,
+//            u32 num_rows, u32 payload size in bytes, followed by num_columns
+//            times a u32 column size in bytes and the encoded column
+
+enum TelemetryStream: uint8_t
+{
+    TELEMETRY_EVENTS = 0,
+    TELEMETRY_TICKS,
+    TELEMETRY_NUM_STREAMS
+};
+
+// One row per GameEvent
+enum TelemetryEventColumn: uint8_t
+{
+    EVENT_COLUMN_GAME = 0,
+    EVENT_COLUMN_TICK,
+    EVENT_COLUMN_TYPE,
+    EVENT_COLUMN_ALIEN_TYPE,
+    EVENT_COLUMN_X,
+    EVENT_COLUMN_Y,
+    EVENT_COLUMN_VALUE,
+    EVENT_NUM_COLUMNS
+};
+
+// One row per simulated tick
+enum TelemetryTickColumn: uint8_t
+{
+    TICK_COLUMN_GAME = 0,
+    TICK_COLUMN_TICK,
+    TICK_COLUMN_SCORE,
+    TICK_COLUMN_LIVES,
+    TICK_COLUMN_ALIENS,
+    TICK_COLUMN_BULLETS,
+    TICK_COLUMN_PLAYER_X,
+    TICK_NUM_COLUMNS
+};
+
+constexpr size_t TELEMETRY_MAX_COLUMNS = 7;
+constexpr size_t TELEMETRY_BLOCK_ROWS = 4096;
+
+struct TelemetryBlock
+{
+    TelemetryStream stream;
+    size_t num_rows;
+    int64_t columns[TELEMETRY_MAX_COLUMNS][TELEMETRY_BLOCK_ROWS];
+};
+
+struct TelemetryLog
+{
+    int fd;
+    uint8_t* data;
+    size_t size;
+    size_t capacity;
+
+    // Only touched by the game thread
+    TelemetryBlock* current[TELEMETRY_NUM_STREAMS];
+
+    // Shared with the writer thread
+    std::unique_ptr<TelemetryBlock[]> blocks;
+    std::vector<TelemetryBlock*> free_blocks;
+    std::vector<TelemetryBlock*> full_blocks;
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::thread writer;
+    bool quit;
+    bool failed;
+};
+
+bool telemetry_open(TelemetryLog* log, const char* path);
+
+// Flushes the partially filled blocks and truncates the file to its contents.
+// Returns false if anything could not be written.
+bool telemetry_close(TelemetryLog* log);
+
+// Hands a full block to the writer thread, only called by the functions below
+void telemetry_submit(TelemetryLog* log, TelemetryStream stream);
+
+inline void telemetry_event(TelemetryLog* log, uint64_t game, uint64_t tick, const GameEvent& event)
+{
+    auto block = log->current[TELEMETRY_EVENTS];
+    size_t row = block->num_rows++;
+    block->columns[EVENT_COLUMN_GAME][row] = game;
+    block->columns[EVENT_COLUMN_TICK][row] = tick;
+    block->columns[EVENT_COLUMN_TYPE][row] = event.type;
+    block->columns[EVENT_COLUMN_ALIEN_TYPE][row] = event.alien_type;
+    block->columns[EVENT_COLUMN_X][row] = event.x;
+    block->columns[EVENT_COLUMN_Y][row] = event.y;
+    block->columns[EVENT_COLUMN_VALUE][row] = event.value;
+
+    if (block->num_rows == TELEMETRY_BLOCK_ROWS) telemetry_submit(log, TELEMETRY_EVENTS);
+}
+
+// Records the events of the last tick and a summary of the game after it.
+// game_id tells apart the games sharing a log.
+void telemetry_record(TelemetryLog* log, uint64_t game_id, const Game& game, const GameEvents& events);
+
+// Reading
+
+struct TelemetryBlockView
+{
+    TelemetryStream stream;
+    size_t num_rows;
+    size_t num_columns;
+    const uint8_t* columns[TELEMETRY_MAX_COLUMNS];
+    size_t column_sizes[TELEMETRY_MAX_COLUMNS];
+};
+
+// Returns the first block of a log, or nullptr if data is not a telemetry log
+const uint8_t* telemetry_first_block(const uint8_t* data, size_t size);
+
+// Parses the block at data and returns where the next block starts, or nullptr
+// at the end of the log or if the block is truncated or corrupt
+const uint8_t* telemetry_read_block(const uint8_t* data, const uint8_t* end, TelemetryBlockView* view);
+
+// Whether the bytes from data to end, where telemetry_read_block() failed, are
+// the cut off end of a log rather than a corrupt block: a block running past
+// end, or the zeros a log still being written is padded with
+bool telemetry_is_partial_block(const uint8_t* data, const uint8_t* end);
+
+// Decodes num_rows values of a column, returns false if it is corrupt
+bool telemetry_decode_column(const TelemetryBlockView& view, size_t column, int64_t* values);
@@ -0,0 +1,177 @@
+#include "upload.h"
+
+#include <utility>
+
+static void uploader_worker(TextureUploader* uploader)
+{
+    glfwMakeContextCurrent(uploader->context);
+
+    std::vector<uint32_t> frame(uploader->width * uploader->height);
+
+    for (;;)
+    {
+        size_t target;
+        uint64_t frame_number;
+        GLsync read_fence;
+        {
+            std::unique_lock lock(uploader->mutex);
+            uploader->changed.wait(lock, [uploader]{ return uploader->has_pending || uploader->quit; });
+            if (uploader->quit) break;
+
+            std::swap(frame, uploader->pending);
+            uploader->has_pending = false;
+            frame_number = uploader->frames_submitted;
+
+            // An upload the render thread has not switched to yet is replaced
+            target = (uploader->displayed + 1) % UPLOADER_NUM_TEXTURES;
+            if (uploader->ready == target)
+            {
+                glDeleteSync(uploader->ready_fence);
+                uploader->ready = UPLOADER_NUM_TEXTURES;
+                uploader->ready_fence = nullptr;
+            }
+
+            read_fence = std::exchange(uploader->read_fences[target], nullptr);
+        }
+
+        // Waits on the GPU, not here, for the last draw from the texture
+        if (read_fence)
+        {
+            glWaitSync(read_fence, 0, GL_TIMEOUT_IGNORED);
+            glDeleteSync(read_fence);
+        }
+
+        glBindTexture(GL_TEXTURE_2D, uploader->textures[target]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+            uploader->width, uploader->height,
+            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
+            frame.data()
+        );
+
+        // The render thread's context only sees the fence once it is flushed
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard lock(uploader->mutex);
+        uploader->ready = target;
+        uploader->ready_frame = frame_number;
+        uploader->ready_fence = fence;
+        ++uploader->frames_uploaded;
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+bool uploader_init(TextureUploader* uploader, GLFWwindow* window, size_t width, size_t height)
+{
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    uploader->context = glfwCreateWindow(1, 1, "", NULL, window);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
+    if (!uploader->context) return false;
+
+    uploader->width = width;
+    uploader->height = height;
+
+    glGenTextures(UPLOADER_NUM_TEXTURES, uploader->textures);
+    for (auto texture : uploader->textures)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexImage2D(
+            GL_TEXTURE_2D, 0, GL_RGB8,
+            width, height, 0,
+            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, nullptr
+        );
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    }
+
+    // The worker's context must see the textures complete
+    glFinish();
+
+    uploader->pending = std::vector<uint32_t>(width * height);
+    uploader->has_pending = false;
+    uploader->frames_submitted = 0;
+    uploader->displayed = 0;
+    uploader->displayed_frame = 0;
+    uploader->ready = UPLOADER_NUM_TEXTURES;
+    uploader->ready_frame = 0;
+    uploader->ready_fence = nullptr;
+    for (auto& fence : uploader->read_fences)
+    {
+        fence = nullptr;
+    }
+    uploader->quit = false;
+    uploader->frames_uploaded = 0;
+    uploader->frames_skipped = 0;
+
+    uploader->worker = std::thread(uploader_worker, uploader);
+    return true;
+}
+
+void uploader_shutdown(TextureUploader* uploader)
+{
+    {
+        std::lock_guard lock(uploader->mutex);
+        uploader->quit = true;
+    }
+    uploader->changed.notify_one();
+    uploader->worker.join();
+
+    if (uploader->ready_fence) glDeleteSync(uploader->ready_fence);
+    for (auto fence : uploader->read_fences)
+    {
+        if (fence) glDeleteSync(fence);
+    }
+    glDeleteTextures(UPLOADER_NUM_TEXTURES, uploader->textures);
+    glfwDestroyWindow(uploader->context);
+}
+
+uint64_t uploader_submit(TextureUploader* uploader, Buffer* buffer)
+{
+    uint64_t frame_number;
+    {
+        std::lock_guard lock(uploader->mutex);
+        if (uploader->has_pending) ++uploader->frames_skipped;
+        std::swap(buffer->data, uploader->pending);
+        uploader->has_pending = true;
+        frame_number = ++uploader->frames_submitted;
+    }
+    uploader->changed.notify_one();
+    return frame_number;
+}
+
+GLuint uploader_texture(TextureUploader* uploader)
+{
+    std::lock_guard lock(uploader->mutex);
+
+    // Only polls the fence, an upload in flight leaves the old frame on screen
+    if (uploader->ready != UPLOADER_NUM_TEXTURES)
+    {
+        GLenum status = glClientWaitSync(uploader->ready_fence, 0, 0);
+        if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+        {
+            glDeleteSync(uploader->ready_fence);
+            uploader->displayed = uploader->ready;
+            uploader->displayed_frame = uploader->ready_frame;
+            uploader->ready = UPLOADER_NUM_TEXTURES;
+            uploader->ready_fence = nullptr;
+        }
+    }
+
+    return uploader->textures[uploader->displayed];
+}
+
+void uploader_release(TextureUploader* uploader)
+{
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    std::lock_guard lock(uploader->mutex);
+    auto& read_fence = uploader->read_fences[uploader->displayed];
+    // Fences signal in order, only the newest one matters
+    if (read_fence) glDeleteSync(read_fence);
+    read_fence = fence;
+}
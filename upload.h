@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "buffer.h"
+
+// Moves the texture upload of each frame off the render thread.
+//
+// A worker thread owns a second GL context, shared with the window's, and
+// uploads the frames into two alternating textures. Each upload ends with a
+// fence, and the render thread switches to a texture only once its fence has
+// signaled, until then it keeps showing the previous frame. In the other
+// direction the render thread fences its last draw from a texture, and the
+// worker waits on that fence on the GPU before overwriting the texture.
+//
+// Frames are handed over by swapping the vector of the buffer, so no pixels
+// are copied on the CPU. A frame that is still waiting when the next one is
+// submitted is replaced and counted as skipped. Frames are numbered from 1 in
+// the order they are submitted, so the render thread can tell when a frame, or
+// a newer one, is on screen.
+
+constexpr size_t UPLOADER_NUM_TEXTURES = 2;
+
+struct TextureUploader
+{
+    GLFWwindow* context;
+    size_t width;
+    size_t height;
+    GLuint textures[UPLOADER_NUM_TEXTURES];
+
+    // Shared with the worker
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<uint32_t> pending;
+    bool has_pending;
+    uint64_t frames_submitted;
+    // The texture on screen, the worker uploads into the other one
+    size_t displayed;
+    uint64_t displayed_frame;
+    // Uploaded texture waiting for its fence, or UPLOADER_NUM_TEXTURES
+    size_t ready;
+    uint64_t ready_frame;
+    GLsync ready_fence;
+    // Signaled once the render thread no longer reads the texture
+    GLsync read_fences[UPLOADER_NUM_TEXTURES];
+    bool quit;
+    std::thread worker;
+
+    uint64_t frames_uploaded;
+    uint64_t frames_skipped;
+};
+
+// Creates the shared context and the textures, the window's context must be
+// current. Returns false if there is no shared context, uploads then have to
+// stay on the render thread.
+bool uploader_init(TextureUploader* uploader, GLFWwindow* window, size_t width, size_t height);
+
+void uploader_shutdown(TextureUploader* uploader);
+
+// Hands the frame in buffer to the worker and returns its number. buffer gets
+// an old frame back, which has to be redrawn completely.
+uint64_t uploader_submit(TextureUploader* uploader, Buffer* buffer);
+
+// The texture with the newest completely uploaded frame, whose number it
+// stores in displayed_frame
+GLuint uploader_texture(TextureUploader* uploader);
+
+// Call after the last draw that reads uploader_texture()
+void uploader_release(TextureUploader* uploader);
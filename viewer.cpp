@@ -0,0 +1,507 @@
+// Plays sessions recorded with invaders --record FILE.
+//
+//   Space         pause, resume
+//   Up, Down      double, halve the speed, from 0.25x to 64x
+//   Left, Right   one tick back, forward
+//   Page Up/Down  ten seconds back, forward
+//   Home, End     start, end
+//   Click         seek on the timeline above the playfield
+//
+// A worker thread replays the session. While idle it runs ahead through the
+// whole file and keeps a snapshot every VIEWER_KEYFRAME_INTERVAL ticks, so any
+// position, forward or backward, is at most that many ticks from a keyframe.
+// The render thread only draws the states it actually shows.
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <mutex>
+#include <print>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "assets.h"
+#include "buffer.h"
+#include "game.h"
+#include "replay.h"
+#include "viewport.h"
+
+constexpr size_t VIEWER_KEYFRAME_INTERVAL = 600;
+constexpr size_t VIEWER_TICK_RATE = 60;
+constexpr double VIEWER_MIN_SPEED = 0.25;
+constexpr double VIEWER_MAX_SPEED = 64.0;
+// Rows of the timeline above the playfield
+constexpr size_t TIMELINE_HEIGHT = 6;
+
+struct Keyframe
+{
+    size_t position;
+    std::vector<uint8_t> snapshot;
+};
+
+// A position on the timeline is a game state: the initial state of a game,
+// then one position per tick, then the next game
+struct Viewer
+{
+    const Replay* replay;
+    const GameAssets* assets;
+    // First position of each game, followed by the number of positions
+    std::vector<size_t> game_starts;
+
+    // Only touched by the worker
+    std::vector<Keyframe> keyframes;
+    Game scan;
+    size_t scan_position;
+    Game state;
+    size_t state_position;
+
+    // Shared with the worker
+    std::mutex mutex;
+    std::condition_variable changed;
+    size_t target;
+    bool quit;
+    Game shown;
+    size_t shown_position;
+    uint64_t shown_version;
+    size_t scanned;
+    std::thread worker;
+};
+
+static size_t viewer_num_positions(const Viewer& viewer)
+{
+    return viewer.game_starts.back();
+}
+
+static size_t viewer_game_index(const Viewer& viewer, size_t position)
+{
+    auto it = std::upper_bound(viewer.game_starts.begin(), viewer.game_starts.end(), position);
+    return size_t(it - viewer.game_starts.begin()) - 1;
+}
+
+// Moves a game from position to position + 1
+static void viewer_step(const Viewer& viewer, Game* game, size_t position)
+{
+    size_t gi = viewer_game_index(viewer, position);
+    const auto& ticks = viewer.replay->games[gi].ticks;
+    size_t tick = position - viewer.game_starts[gi];
+
+    if (tick < ticks.size()) replay_step(game, *viewer.assets, ticks[tick]);
+    else game_init(game, *viewer.assets, viewer.replay->config, viewer.replay->games[gi + 1].seed);
+}
+
+// Runs the scan up to limit, taking keyframes on the way
+static void viewer_scan(Viewer* viewer, size_t limit)
+{
+    limit = std::min(limit, viewer_num_positions(*viewer) - 1);
+
+    while (viewer->scan_position < limit)
+    {
+        viewer_step(*viewer, &viewer->scan, viewer->scan_position);
+        size_t position = ++viewer->scan_position;
+
+        size_t gi = viewer_game_index(*viewer, position);
+        if ((position - viewer->game_starts[gi]) % VIEWER_KEYFRAME_INTERVAL != 0) continue;
+
+        Keyframe keyframe;
+        keyframe.position = position;
+        keyframe.snapshot.resize(game_snapshot_size(viewer->scan));
+        game_snapshot(viewer->scan, keyframe.snapshot.data());
+        viewer->keyframes.push_back(std::move(keyframe));
+    }
+}
+
+static void viewer_seek(Viewer* viewer, size_t target)
+{
+    viewer_scan(viewer, target);
+
+    auto it = std::upper_bound(viewer->keyframes.begin(), viewer->keyframes.end(), target,
+        [](size_t position, const Keyframe& keyframe) { return position < keyframe.position; });
+    const auto& keyframe = *(it - 1);
+
+    // Going back, or further ahead than the next keyframe, starts from a keyframe
+    if (viewer->state_position > target || viewer->state_position < keyframe.position)
+    {
+        game_restore(&viewer->state, *viewer->assets, keyframe.snapshot.data(), keyframe.snapshot.size());
+        viewer->state_position = keyframe.position;
+    }
+
+    while (viewer->state_position < target)
+    {
+        viewer_step(*viewer, &viewer->state, viewer->state_position);
+        ++viewer->state_position;
+    }
+}
+
+static void viewer_worker(Viewer* viewer)
+{
+    size_t last_position = viewer_num_positions(*viewer) - 1;
+
+    for (;;)
+    {
+        size_t target;
+        {
+            std::unique_lock lock(viewer->mutex);
+            viewer->changed.wait(lock, [viewer, last_position]{
+                return viewer->quit || viewer->target != viewer->state_position ||
+                    viewer->scan_position < last_position;
+            });
+            if (viewer->quit) break;
+            target = viewer->target;
+        }
+
+        if (target != viewer->state_position)
+        {
+            viewer_seek(viewer, target);
+
+            std::lock_guard lock(viewer->mutex);
+            viewer->shown = viewer->state;
+            viewer->shown_position = viewer->state_position;
+            ++viewer->shown_version;
+            viewer->scanned = viewer->scan_position;
+        }
+        else
+        {
+            viewer_scan(viewer, viewer->scan_position + VIEWER_KEYFRAME_INTERVAL);
+
+            std::lock_guard lock(viewer->mutex);
+            viewer->scanned = viewer->scan_position;
+        }
+    }
+}
+
+static void viewer_init(Viewer* viewer, const Replay& replay, const GameAssets& assets)
+{
+    viewer->replay = &replay;
+    viewer->assets = &assets;
+
+    viewer->game_starts.clear();
+    size_t position = 0;
+    for (const auto& game : replay.games)
+    {
+        viewer->game_starts.push_back(position);
+        position += game.ticks.size() + 1;
+    }
+    viewer->game_starts.push_back(position);
+
+    game_init(&viewer->scan, assets, replay.config, replay.games[0].seed);
+    viewer->scan_position = 0;
+    viewer->state = viewer->scan;
+    viewer->state_position = 0;
+    viewer->shown = viewer->scan;
+    viewer->shown_position = 0;
+    viewer->shown_version = 1;
+
+    Keyframe keyframe;
+    keyframe.position = 0;
+    keyframe.snapshot.resize(game_snapshot_size(viewer->scan));
+    game_snapshot(viewer->scan, keyframe.snapshot.data());
+    viewer->keyframes.clear();
+    viewer->keyframes.push_back(std::move(keyframe));
+
+    viewer->target = 0;
+    viewer->quit = false;
+    viewer->scanned = 0;
+    viewer->worker = std::thread(viewer_worker, viewer);
+}
+
+static void viewer_shutdown(Viewer* viewer)
+{
+    {
+        std::lock_guard lock(viewer->mutex);
+        viewer->quit = true;
+    }
+    viewer->changed.notify_one();
+    viewer->worker.join();
+}
+
+static void timeline_render(const Viewer& viewer, size_t position, size_t scanned, size_t y, Buffer* buffer)
+{
+    const auto background = rgb_to_uint32(40, 40, 40);
+    const auto scanned_color = rgb_to_uint32(80, 80, 80);
+    const auto played_color = rgb_to_uint32(128, 0, 0);
+    const auto boundary_color = rgb_to_uint32(255, 255, 255);
+
+    size_t num_positions = viewer_num_positions(viewer);
+    size_t played_x = (position + 1) * buffer->width / num_positions;
+    size_t scanned_x = (scanned + 1) * buffer->width / num_positions;
+
+    for (size_t row = y; row < y + TIMELINE_HEIGHT; ++row)
+    {
+        uint32_t* pixels = buffer->data.data() + row * buffer->width;
+        for (size_t x = 0; x < buffer->width; ++x)
+        {
+            pixels[x] = x < played_x ? played_color : x < scanned_x ? scanned_color : background;
+        }
+
+        // Where each game starts
+        for (size_t gi = 1; gi + 1 < viewer.game_starts.size(); ++gi)
+        {
+            pixels[viewer.game_starts[gi] * buffer->width / num_positions] = boundary_color;
+        }
+    }
+}
+
+static std::string format_time(size_t ticks)
+{
+    size_t seconds = ticks / VIEWER_TICK_RATE;
+    return std::format("{}:{:02}:{:02}", seconds / 3600, seconds / 60 % 60, seconds % 60);
+}
+
+void error_callback(int error, const char* description)
+{
+    std::println("Error: {}", description);
+}
+
+bool viewer_running = false;
+bool playing = true;
+double speed = 1.0;
+// Set by the input callbacks, applied once a frame
+int64_t step_request = 0;
+bool seek_start = false;
+bool seek_end = false;
+// Fraction of the timeline clicked, or negative
+double seek_fraction = -1.0;
+
+int framebuffer_width = 0;
+int framebuffer_height = 0;
+bool framebuffer_resized = true;
+Viewport viewport;
+// Rows of the buffer, the timeline is on top
+size_t buffer_rows = 0;
+
+void key_callback(GLFWwindow* window, int key, int scancode, int action, int modes)
+{
+    bool pressed = action == GLFW_PRESS || action == GLFW_REPEAT;
+    if (!pressed) return;
+
+    switch (key)
+    {
+    case GLFW_KEY_ESCAPE: viewer_running = false; break;
+    case GLFW_KEY_SPACE: playing = !playing; break;
+    case GLFW_KEY_UP: speed = std::min(speed * 2.0, VIEWER_MAX_SPEED); break;
+    case GLFW_KEY_DOWN: speed = std::max(speed / 2.0, VIEWER_MIN_SPEED); break;
+    case GLFW_KEY_RIGHT: playing = false; step_request += 1; break;
+    case GLFW_KEY_LEFT: playing = false; step_request -= 1; break;
+    case GLFW_KEY_PAGE_DOWN: step_request += 10 * VIEWER_TICK_RATE; break;
+    case GLFW_KEY_PAGE_UP: step_request -= 10 * VIEWER_TICK_RATE; break;
+    case GLFW_KEY_HOME: seek_start = true; break;
+    case GLFW_KEY_END: seek_end = true; break;
+    default: break;
+    }
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int modes)
+{
+    if (button != GLFW_MOUSE_BUTTON_LEFT || action != GLFW_PRESS) return;
+    if (viewport.width <= 0 || viewport.height <= 0) return;
+
+    // Cursor positions are in window coordinates, from the top left
+    double cursor_x, cursor_y;
+    int window_width, window_height;
+    glfwGetCursorPos(window, &cursor_x, &cursor_y);
+    glfwGetWindowSize(window, &window_width, &window_height);
+    if (window_width <= 0 || window_height <= 0) return;
+
+    double x = cursor_x * framebuffer_width / window_width - viewport.x;
+    double y = (window_height - cursor_y) * framebuffer_height / window_height - viewport.y;
+    double row = y * buffer_rows / viewport.height;
+
+    if (x >= 0.0 && x < viewport.width && row >= double(buffer_rows - TIMELINE_HEIGHT) && row < buffer_rows)
+    {
+        seek_fraction = x / viewport.width;
+    }
+}
+
+void framebuffer_size_callback(GLFWwindow* window, int width, int height)
+{
+    framebuffer_width = width;
+    framebuffer_height = height;
+    framebuffer_resized = true;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::println("Usage: invaders_viewer REPLAY");
+        return -1;
+    }
+
+    Replay replay;
+    if (!replay_load(&replay, argv[1]))
+    {
+        std::println("Error reading replay {}", argv[1]);
+        return -1;
+    }
+
+    glfwSetErrorCallback(error_callback);
+
+    if (!glfwInit())
+    {
+        return -1;
+    }
+
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    Buffer buffer;
+    buffer.width = replay.config.width;
+    buffer.height = replay.config.height + TIMELINE_HEIGHT;
+    buffer.data = std::vector<uint32_t>(buffer.width * buffer.height);
+    buffer_rows = buffer.height;
+
+    int window_width = int(std::min<size_t>(2 * buffer.width, 1024));
+    int window_height = int(std::min<size_t>(2 * buffer.height, 1024));
+    auto window = glfwCreateWindow(window_width, window_height, "Space Invaders Replay", NULL, NULL);
+
+    if (!window)
+    {
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwMakeContextCurrent(window);
+    glfwSetKeyCallback(window, key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
+    glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
+
+    if (glewInit() != GLEW_OK)
+    {
+        std::println("Error initializing GLEW.");
+        glfwTerminate();
+        return -1;
+    }
+
+    glfwSwapInterval(1);
+    glClearColor(0.0, 0.0, 0.0, 1.0);
+
+    // The buffer is scaled to the window by a blit, no shaders needed
+    GLuint buffer_texture;
+    glGenTextures(1, &buffer_texture);
+    glBindTexture(GL_TEXTURE_2D, buffer_texture);
+    glTexImage2D(
+        GL_TEXTURE_2D, 0, GL_RGB8,
+        buffer.width, buffer.height, 0,
+        GL_RGBA, GL_UNSIGNED_INT_8_8_8_8, buffer.data.data()
+    );
+
+    GLuint buffer_fbo;
+    glGenFramebuffers(1, &buffer_fbo);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, buffer_fbo);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, buffer_texture, 0);
+
+    if (glCheckFramebufferStatus(GL_READ_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        std::println("Framebuffer incomplete.");
+        glfwTerminate();
+        return -1;
+    }
+
+    GameAssets assets;
+    assets_init(&assets);
+
+    Viewer viewer;
+    viewer_init(&viewer, replay, assets);
+    size_t last_position = viewer_num_positions(viewer) - 1;
+
+    // A copy of the state on screen, the worker keeps going meanwhile
+    Game shown = viewer.shown;
+    uint64_t shown_version = 0;
+    size_t shown_position = 0;
+    size_t scanned = 0;
+
+    double playhead = 0.0;
+    double last_time = glfwGetTime();
+    std::string title;
+
+    viewer_running = true;
+
+    while (!glfwWindowShouldClose(window) && viewer_running)
+    {
+        double now = glfwGetTime();
+        if (playing) playhead += speed * VIEWER_TICK_RATE * (now - last_time);
+        last_time = now;
+
+        if (step_request != 0)
+        {
+            playhead = std::floor(playhead) + double(step_request);
+            step_request = 0;
+        }
+        if (seek_fraction >= 0.0)
+        {
+            playhead = seek_fraction * last_position;
+            seek_fraction = -1.0;
+        }
+        if (seek_start) playhead = 0.0;
+        if (seek_end) playhead = double(last_position);
+        seek_start = seek_end = false;
+
+        playhead = std::clamp(playhead, 0.0, double(last_position));
+        if (playhead == double(last_position)) playing = false;
+
+        {
+            std::lock_guard lock(viewer.mutex);
+            viewer.target = size_t(playhead);
+
+            if (viewer.shown_version != shown_version)
+            {
+                shown = viewer.shown;
+                shown_version = viewer.shown_version;
+                shown_position = viewer.shown_position;
+            }
+            scanned = viewer.scanned;
+        }
+        viewer.changed.notify_one();
+
+        game_render(shown, assets, &buffer);
+        timeline_render(viewer, shown_position, scanned, replay.config.height, &buffer);
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0,
+            buffer.width, buffer.height,
+            GL_RGBA, GL_UNSIGNED_INT_8_8_8_8,
+            buffer.data.data()
+        );
+
+        if (framebuffer_resized)
+        {
+            viewport = viewport_fit(int(buffer.width), int(buffer.height), framebuffer_width, framebuffer_height);
+            framebuffer_resized = false;
+        }
+
+        glClear(GL_COLOR_BUFFER_BIT);
+        glBlitFramebuffer(0, 0, int(buffer.width), int(buffer.height),
+            viewport.x, viewport.y, viewport.x + viewport.width, viewport.y + viewport.height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+        glfwSwapBuffers(window);
+
+        std::string new_title = std::format("Replay {} / {}  {}x{}", format_time(shown_position),
+            format_time(last_position), speed, playing ? "" : "  paused");
+        if (new_title != title)
+        {
+            title = new_title;
+            glfwSetWindowTitle(window, title.c_str());
+        }
+
+        glfwPollEvents();
+    }
+
+    viewer_shutdown(&viewer);
+
+    glDeleteFramebuffers(1, &buffer_fbo);
+    glDeleteTextures(1, &buffer_texture);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return 0;
+}
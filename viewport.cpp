@@ -0,0 +1,29 @@
+#include "viewport.h"
+
+#include <algorithm>
+#include <cstdint>
+
+Viewport viewport_fit(int buffer_width, int buffer_height, int framebuffer_width, int framebuffer_height)
+{
+    Viewport viewport;
+    int scale = std::min(framebuffer_width / buffer_width, framebuffer_height / buffer_height);
+    if (scale >= 1)
+    {
+        viewport.width = buffer_width * scale;
+        viewport.height = buffer_height * scale;
+    }
+    else if (int64_t(framebuffer_width) * buffer_height < int64_t(framebuffer_height) * buffer_width)
+    {
+        viewport.width = framebuffer_width;
+        viewport.height = int(int64_t(framebuffer_width) * buffer_height / buffer_width);
+    }
+    else
+    {
+        viewport.width = int(int64_t(framebuffer_height) * buffer_width / buffer_height);
+        viewport.height = framebuffer_height;
+    }
+
+    viewport.x = (framebuffer_width - viewport.width) / 2;
+    viewport.y = (framebuffer_height - viewport.height) / 2;
+    return viewport;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// The buffer is shown at the largest whole multiple of its size that fits the
+// framebuffer, centered with black bars, so pixels stay square and sharp. A
+// framebuffer smaller than the buffer gets the largest aspect-correct fit.
+struct Viewport
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+Viewport viewport_fit(int buffer_width, int buffer_height, int framebuffer_width, int framebuffer_height);